@@ -0,0 +1,547 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+/*
+ * Microbenchmarks for BufMgr.
+ *
+ * Runs readPage/unPinPage under uniform, Zipfian and sequential-scan access for a working set that fits
+ * the pool (hits) and one four times its size (misses), a mixed read/update/allocate workload, and
+ * allocPage, flushFile and disposePage on their own, for every combination of pool size and thread count.
+ * allocBuf is private; its cost shows up in the allocBuf histogram of the miss and allocPage runs.
+ *
+ * Results are printed as JSON in the layout Google Benchmark uses for --benchmark_format=json, with the
+ * fields its tools/compare.py reads, so two runs can be diffed with
+ *
+ *   compare.py benchmarks before.json after.json
+ *
+ * cpu_time is the CPU time of the whole process over the run, summed over threads, per iteration.
+ *
+ *   bufmgr_bench [--pool-sizes=64,1024] [--threads=1,4] [--ops=200000] [--out=results.json]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+#include "buffer.h"
+#include "file.h"
+#include "page.h"
+#include "exceptions/file_not_found_exception.h"
+
+using namespace badgerdb;
+
+namespace {
+
+const std::string BENCH_FILE = "bufmgr_bench.db";
+
+/*
+ * Zipfian generator over [0, n) following Gray et al., "Quickly Generating Billion-Record Synthetic Databases",
+ * the same one YCSB uses.
+ */
+class ZipfianGenerator
+{
+ public:
+	ZipfianGenerator(std::uint64_t nIn, double thetaIn)
+		: n(nIn), theta(thetaIn), dist(0.0, 1.0)
+	{
+		zetan = zeta(n);
+		double zeta2 = zeta(2);
+		alpha = 1.0 / (1.0 - theta);
+		eta = (1.0 - std::pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / zetan);
+	}
+
+	std::uint64_t next(std::mt19937_64& rng)
+	{
+		double u = dist(rng);
+		double uz = u * zetan;
+		if(uz < 1.0) return 0;
+		if(uz < 1.0 + std::pow(0.5, theta)) return 1;
+		return std::min<std::uint64_t>(n - 1, (std::uint64_t) (n * std::pow(eta * u - eta + 1.0, alpha)));
+	}
+
+ private:
+	double zeta(std::uint64_t count)
+	{
+		double sum = 0;
+		for(std::uint64_t i = 1; i <= count; i++) {
+			sum += 1.0 / std::pow((double) i, theta);
+		}
+		return sum;
+	}
+
+	std::uint64_t n;
+	double theta;
+	double zetan;
+	double alpha;
+	double eta;
+	std::uniform_real_distribution<double> dist;
+};
+
+enum Workload { UNIFORM, ZIPFIAN, SEQUENTIAL };
+
+const char* workloadName(Workload workload)
+{
+	switch(workload) {
+		case UNIFORM: return "uniform";
+		case ZIPFIAN: return "zipfian";
+		default: return "sequential";
+	}
+}
+
+/*
+ * Picks the next page of the working set for one thread.
+ */
+class PagePicker
+{
+ public:
+	PagePicker(Workload workloadIn, std::uint64_t pagesIn, std::uint64_t seed)
+		: workload(workloadIn), pages(pagesIn), rng(seed), uniform(0, pagesIn - 1), zipf(pagesIn, 0.99), cursor(seed % pagesIn) {}
+
+	//page numbers start at 1
+	PageId next()
+	{
+		switch(workload) {
+			case UNIFORM: return (PageId) uniform(rng) + 1;
+			case ZIPFIAN: return (PageId) zipf.next(rng) + 1;
+			default: cursor = (cursor + 1) % pages; return (PageId) cursor + 1;
+		}
+	}
+
+	std::mt19937_64& random() { return rng; }
+
+ private:
+	Workload workload;
+	std::uint64_t pages;
+	std::mt19937_64 rng;
+	std::uniform_int_distribution<std::uint64_t> uniform;
+	ZipfianGenerator zipf;
+	std::uint64_t cursor;
+};
+
+struct Config
+{
+	std::vector<std::uint32_t> poolSizes;
+	std::vector<std::uint32_t> threads;
+	std::uint64_t ops;
+	std::string out;
+};
+
+/*
+ * Wall and CPU time of a run, in nanoseconds
+ */
+struct Timing
+{
+	double realNanos;
+	double cpuNanos;
+};
+
+struct Result
+{
+	std::string name;
+	std::string op;
+	std::uint32_t threads;
+	std::uint64_t iterations;
+	Timing timing;
+	BufStats stats;
+	BufLatency latency;
+};
+
+/*
+ * Removes the benchmark file, if there is one.
+ */
+void removeBenchFile()
+{
+	try {
+		File::remove(BENCH_FILE);
+	} catch(FileNotFoundException& e) {
+	}
+}
+
+/*
+ * Removes the benchmark file when it goes away. Declared ahead of the file in Fixture, so the file is closed by then.
+ */
+struct BenchFileRemover
+{
+	~BenchFileRemover()
+	{
+		removeBenchFile();
+	}
+};
+
+/*
+ * One benchmark run: a fresh file and a fresh buffer manager shared by all worker threads.
+ */
+class Fixture
+{
+ public:
+	Fixture(std::uint32_t poolSize, std::uint64_t filePages)
+		: file(PageFile::create(BENCH_FILE)), bufMgr(new BufMgr(poolSize))
+	{
+		for(std::uint64_t i = 0; i < filePages; i++) {
+			PageId pageNo;
+			Page* page;
+			bufMgr->allocPage(&file, pageNo, page);
+			bufMgr->unPinPage(&file, pageNo, true);
+		}
+		bufMgr->flushFile(&file);
+		bufMgr->clearBufStats();
+		bufMgr->setLatencyTracking(true);
+	}
+
+	//members go in reverse order: the buffer manager writes its pages back, then the file is closed and removed
+	BenchFileRemover remover;
+	PageFile file;
+	std::unique_ptr<BufMgr> bufMgr;
+};
+
+/*
+ * CPU time used by all threads of the process so far, in nanoseconds
+ */
+double processCpuNanos()
+{
+	timespec ts;
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/*
+ * Measures wall and CPU time from its construction.
+ */
+class Stopwatch
+{
+ public:
+	Stopwatch()
+		: start(std::chrono::steady_clock::now()), cpuStart(processCpuNanos()) {}
+
+	Timing elapsed() const
+	{
+		Timing timing;
+		timing.realNanos = (double) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		timing.cpuNanos = processCpuNanos() - cpuStart;
+		return timing;
+	}
+
+ private:
+	std::chrono::steady_clock::time_point start;
+	double cpuStart;
+};
+
+/*
+ * Runs body(threadNo, opsForThread) on the given number of threads and returns how long it took.
+ */
+template <typename Body>
+Timing runThreads(std::uint32_t numThreads, std::uint64_t ops, Body body)
+{
+	std::vector<std::thread> workers;
+	Stopwatch stopwatch;
+	for(std::uint32_t t = 0; t < numThreads; t++) {
+		workers.push_back(std::thread(body, t, ops / numThreads));
+	}
+	for(std::size_t t = 0; t < workers.size(); t++) {
+		workers[t].join();
+	}
+	return stopwatch.elapsed();
+}
+
+std::string label(const std::string& op, std::uint32_t poolSize, std::uint32_t numThreads)
+{
+	std::ostringstream ss;
+	ss << op << "/pool:" << poolSize << "/threads:" << numThreads;
+	return ss.str();
+}
+
+Result finish(const std::string& op, std::uint32_t poolSize, std::uint32_t numThreads, Fixture& fixture,
+		std::uint64_t iterations, const Timing& timing)
+{
+	Result result;
+	result.name = label(op, poolSize, numThreads);
+	result.op = op;
+	result.threads = numThreads;
+	result.iterations = iterations;
+	result.timing = timing;
+	result.stats = fixture.bufMgr->getBufStatsSnapshot();
+	result.latency = fixture.bufMgr->getBufLatency();
+	return result;
+}
+
+/*
+ * readPage followed by unPinPage. A working set of half the pool measures hits, four times the pool measures misses.
+ */
+Result benchRead(const Config& config, std::uint32_t poolSize, std::uint32_t numThreads, Workload workload, bool fits)
+{
+	std::uint64_t workingSet = fits ? std::max<std::uint64_t>(1, poolSize / 2) : (std::uint64_t) poolSize * 4;
+	Fixture fixture(poolSize, workingSet);
+
+	if(fits) {
+		for(PageId pageNo = 1; pageNo <= workingSet; pageNo++) {
+			Page* page;
+			fixture.bufMgr->readPage(&fixture.file, pageNo, page);
+			fixture.bufMgr->unPinPage(&fixture.file, pageNo, false);
+		}
+		fixture.bufMgr->clearBufStats();
+		fixture.bufMgr->clearBufLatency();
+	}
+
+	Timing timing = runThreads(numThreads, config.ops, [&](std::uint32_t t, std::uint64_t ops) {
+		PagePicker picker(workload, workingSet, t + 1);
+		for(std::uint64_t i = 0; i < ops; i++) {
+			PageId pageNo = picker.next();
+			Page* page;
+			fixture.bufMgr->readPage(&fixture.file, pageNo, page);
+			fixture.bufMgr->unPinPage(&fixture.file, pageNo, false);
+		}
+	});
+
+	std::string op = std::string(fits ? "readPage_hit/" : "readPage_miss/") + workloadName(workload);
+	return finish(op, poolSize, numThreads, fixture, config.ops, timing);
+}
+
+/*
+ * 70% reads, 20% updates (unpinned dirty), 10% allocPage, Zipfian over a working set twice the pool.
+ */
+Result benchMixed(const Config& config, std::uint32_t poolSize, std::uint32_t numThreads)
+{
+	std::uint64_t workingSet = (std::uint64_t) poolSize * 2;
+	Fixture fixture(poolSize, workingSet);
+
+	Timing timing = runThreads(numThreads, config.ops, [&](std::uint32_t t, std::uint64_t ops) {
+		PagePicker picker(ZIPFIAN, workingSet, t + 1);
+		std::uniform_int_distribution<int> percent(0, 99);
+		for(std::uint64_t i = 0; i < ops; i++) {
+			int roll = percent(picker.random());
+			PageId pageNo = picker.next();
+			Page* page;
+			if(roll < 10) {
+				fixture.bufMgr->allocPage(&fixture.file, pageNo, page);
+				fixture.bufMgr->unPinPage(&fixture.file, pageNo, true);
+			}
+			else {
+				fixture.bufMgr->readPage(&fixture.file, pageNo, page);
+				fixture.bufMgr->unPinPage(&fixture.file, pageNo, roll < 30);
+			}
+		}
+	});
+
+	return finish("mixed/zipfian", poolSize, numThreads, fixture, config.ops, timing);
+}
+
+Result benchAllocPage(const Config& config, std::uint32_t poolSize, std::uint32_t numThreads)
+{
+	Fixture fixture(poolSize, 0);
+
+	Timing timing = runThreads(numThreads, config.ops, [&](std::uint32_t, std::uint64_t ops) {
+		for(std::uint64_t i = 0; i < ops; i++) {
+			PageId pageNo;
+			Page* page;
+			fixture.bufMgr->allocPage(&fixture.file, pageNo, page);
+			fixture.bufMgr->unPinPage(&fixture.file, pageNo, true);
+		}
+	});
+
+	return finish("allocPage", poolSize, numThreads, fixture, config.ops, timing);
+}
+
+/*
+ * Dirties the whole pool and flushes it, over and over. One iteration is one flushFile call.
+ * Threads do not apply, flushFile empties the pool for everyone.
+ */
+Result benchFlushFile(const Config& config, std::uint32_t poolSize)
+{
+	Fixture fixture(poolSize, poolSize);
+	std::uint64_t rounds = std::max<std::uint64_t>(1, config.ops / poolSize);
+	Timing timing = { 0, 0 };
+
+	for(std::uint64_t r = 0; r < rounds; r++) {
+		for(PageId pageNo = 1; pageNo <= poolSize; pageNo++) {
+			Page* page;
+			fixture.bufMgr->readPage(&fixture.file, pageNo, page);
+			fixture.bufMgr->unPinPage(&fixture.file, pageNo, true);
+		}
+
+		Stopwatch stopwatch;
+		fixture.bufMgr->flushFile(&fixture.file);
+		Timing flush = stopwatch.elapsed();
+		timing.realNanos += flush.realNanos;
+		timing.cpuNanos += flush.cpuNanos;
+	}
+
+	return finish("flushFile", poolSize, 1, fixture, rounds, timing);
+}
+
+/*
+ * Allocates a batch of pages and times disposing them, half of them still resident.
+ */
+Result benchDisposePage(const Config& config, std::uint32_t poolSize, std::uint32_t numThreads)
+{
+	Fixture fixture(poolSize, 0);
+	std::uint64_t count = std::min<std::uint64_t>(config.ops, (std::uint64_t) poolSize * 2);
+	std::vector<PageId> pageNos;
+
+	for(std::uint64_t i = 0; i < count; i++) {
+		PageId pageNo;
+		Page* page;
+		fixture.bufMgr->allocPage(&fixture.file, pageNo, page);
+		fixture.bufMgr->unPinPage(&fixture.file, pageNo, true);
+		pageNos.push_back(pageNo);
+	}
+
+	Timing timing = runThreads(numThreads, count, [&](std::uint32_t t, std::uint64_t ops) {
+		for(std::uint64_t i = 0; i < ops; i++) {
+			fixture.bufMgr->disposePage(&fixture.file, pageNos[t * ops + i]);
+		}
+	});
+
+	return finish("disposePage", poolSize, numThreads, fixture, count, timing);
+}
+
+std::vector<std::uint32_t> parseList(const std::string& value)
+{
+	std::vector<std::uint32_t> values;
+	std::istringstream ss(value);
+	std::string item;
+	while(std::getline(ss, item, ',')) {
+		values.push_back((std::uint32_t) std::strtoul(item.c_str(), NULL, 10));
+	}
+	return values;
+}
+
+Config parseArgs(int argc, char** argv)
+{
+	Config config;
+	config.poolSizes.push_back(64);
+	config.poolSizes.push_back(1024);
+	config.threads.push_back(1);
+	config.threads.push_back(4);
+	config.ops = 200000;
+
+	for(int i = 1; i < argc; i++) {
+		std::string arg(argv[i]);
+		std::string value = arg.substr(arg.find('=') + 1);
+		if(arg.find("--pool-sizes=") == 0) config.poolSizes = parseList(value);
+		else if(arg.find("--threads=") == 0) config.threads = parseList(value);
+		else if(arg.find("--ops=") == 0) config.ops = std::strtoull(value.c_str(), NULL, 10);
+		else if(arg.find("--out=") == 0) config.out = value;
+		else {
+			std::cerr << "usage: " << argv[0] << " [--pool-sizes=a,b] [--threads=a,b] [--ops=n] [--out=file]\n";
+			std::exit(1);
+		}
+	}
+	return config;
+}
+
+void printJson(std::ostream& out, const std::vector<Result>& results)
+{
+	char date[64];
+	std::time_t now = std::time(NULL);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+	char host[256] = "";
+	gethostname(host, sizeof(host) - 1);
+
+	out << "{\n  \"context\": {\n";
+	out << "    \"date\": \"" << date << "\",\n";
+	out << "    \"host_name\": \"" << host << "\",\n";
+	out << "    \"executable\": \"bufmgr_bench\",\n";
+	out << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+	out << "    \"library_build_type\": \"release\",\n";
+#else
+	out << "    \"library_build_type\": \"debug\",\n";
+#endif
+	out << "    \"page_size\": " << Page::SIZE << "\n";
+	out << "  },\n  \"benchmarks\": [\n";
+
+	//compare.py groups runs by family (the operation) and orders them by their index within it
+	std::vector<std::string> families;
+	std::vector<int> instances;
+	for(std::size_t i = 0; i < results.size(); i++) {
+		const Result& r = results[i];
+		std::size_t family = std::find(families.begin(), families.end(), r.op) - families.begin();
+		if(family == families.size()) {
+			families.push_back(r.op);
+			instances.push_back(0);
+		}
+		double perOp = r.iterations == 0 ? 0 : r.timing.realNanos / r.iterations;
+		double cpuPerOp = r.iterations == 0 ? 0 : r.timing.cpuNanos / r.iterations;
+		std::uint64_t lookups = r.stats.hits + r.stats.misses;
+
+		out << "    {\n";
+		out << "      \"name\": \"" << r.name << "\",\n";
+		out << "      \"family_index\": " << family << ",\n";
+		out << "      \"per_family_instance_index\": " << instances[family]++ << ",\n";
+		out << "      \"run_name\": \"" << r.name << "\",\n";
+		out << "      \"run_type\": \"iteration\",\n";
+		out << "      \"repetitions\": 1,\n";
+		out << "      \"repetition_index\": 0,\n";
+		out << "      \"threads\": " << r.threads << ",\n";
+		out << "      \"iterations\": " << r.iterations << ",\n";
+		out << "      \"real_time\": " << perOp << ",\n";
+		out << "      \"cpu_time\": " << cpuPerOp << ",\n";
+		out << "      \"time_unit\": \"ns\",\n";
+		out << "      \"items_per_second\": " << (perOp == 0 ? 0 : 1e9 / perOp) << ",\n";
+		out << "      \"hit_ratio\": " << (lookups == 0 ? 0.0 : (double) r.stats.hits / lookups) << ",\n";
+		out << "      \"evictions\": " << r.stats.evictions << ",\n";
+		out << "      \"dirty_evictions\": " << r.stats.dirtyEvictions << ",\n";
+		out << "      \"disk_reads\": " << r.stats.diskreads << ",\n";
+		out << "      \"disk_writes\": " << r.stats.diskwrites << ",\n";
+		out << "      \"read_hit_p99_ns\": " << r.latency.readHit.percentile(99) << ",\n";
+		out << "      \"read_miss_p99_ns\": " << r.latency.readMiss.percentile(99) << ",\n";
+		out << "      \"alloc_buf_p50_ns\": " << r.latency.allocBuf.percentile(50) << ",\n";
+		out << "      \"alloc_buf_p99_ns\": " << r.latency.allocBuf.percentile(99) << "\n";
+		out << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	Config config = parseArgs(argc, argv);
+	std::vector<Result> results;
+	const Workload workloads[] = { UNIFORM, ZIPFIAN, SEQUENTIAL };
+
+	//anything left over from an interrupted run
+	removeBenchFile();
+
+	for(std::size_t p = 0; p < config.poolSizes.size(); p++) {
+		std::uint32_t poolSize = config.poolSizes[p];
+		results.push_back(benchFlushFile(config, poolSize));
+
+		for(std::size_t t = 0; t < config.threads.size(); t++) {
+			std::uint32_t numThreads = config.threads[t];
+			for(int w = 0; w < 3; w++) {
+				results.push_back(benchRead(config, poolSize, numThreads, workloads[w], true));
+				results.push_back(benchRead(config, poolSize, numThreads, workloads[w], false));
+			}
+			results.push_back(benchMixed(config, poolSize, numThreads));
+			results.push_back(benchAllocPage(config, poolSize, numThreads));
+			results.push_back(benchDisposePage(config, poolSize, numThreads));
+			std::cerr << "done pool:" << poolSize << " threads:" << numThreads << "\n";
+		}
+	}
+
+	if(config.out.empty()) {
+		printJson(std::cout, results);
+	}
+	else {
+		std::ofstream out(config.out.c_str());
+		printJson(out, results);
+	}
+	return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <mutex>
+#include "frameBitmap.h"
+
+/**
+ * Choices about the buffer manager that are fixed when it is built rather than when it is constructed. They are
+ * the template parameters of BasicBufMgr; BufMgr takes the defaults below.
+ *
+ * BADGERDB_BUF_SINGLE_THREADED: BufMgr is only ever used from one thread. Its mutex is then NullMutex instead of
+ * std::mutex, so every public call skips the lock and unlock, and disposed pages are deleted by the calling thread
+ * instead of a background task. Waiting for a frame with setFrameWaitTimeout() makes no sense in this mode, as
+ * nobody else can unpin one. A BasicBufMgr with NullMutex behaves the same in any build.
+ */
+
+namespace badgerdb {
+
+/**
+* @brief Mutex that does nothing, for buffer managers built for a single thread.
+*/
+class NullMutex
+{
+ public:
+  void lock()
+  {
+  }
+
+  void unlock()
+  {
+  }
+
+  bool try_lock()
+  {
+    return true;
+  }
+};
+
+/**
+ * Tells whether a mutex type lets several threads into a buffer manager. Only NullMutex does not.
+ */
+template<class Latching>
+struct LatchingTraits
+{
+  static const bool threaded = true;
+};
+
+template<>
+struct LatchingTraits<NullMutex>
+{
+  static const bool threaded = false;
+};
+
+/**
+ * Replacement policy of BufMgr, the clock
+ */
+typedef FrameBitmap ClockReplacement;
+
+#ifdef BADGERDB_BUF_SINGLE_THREADED
+/**
+ * Mutex protecting the buffer pool metadata
+ */
+typedef NullMutex BufMutex;
+#else
+/**
+ * Mutex protecting the buffer pool metadata
+ */
+typedef std::mutex BufMutex;
+#endif
+
+}
@@ -0,0 +1,137 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <iostream>
+#include "bufPoolRegistry.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+
+namespace badgerdb {
+
+const std::string BufPoolRegistry::DEFAULT_POOL = "default";
+
+/*
+ * Creates the registry with only the default pool in it.
+ */
+BufPoolRegistry::BufPoolRegistry(std::uint32_t defaultBufs)
+{
+	defaultPool = new BufMgr(defaultBufs);
+	pools[DEFAULT_POOL] = defaultPool;
+}
+
+/*
+ * Deletes every pool. Each BufMgr writes out its own dirty pages on the way out.
+ */
+BufPoolRegistry::~BufPoolRegistry()
+{
+	for(std::map<std::string, BufMgr*>::iterator it = pools.begin(); it != pools.end(); ++it) {
+		delete it->second;
+	}
+}
+
+void BufPoolRegistry::createPool(const std::string& name, std::uint32_t bufs)
+{
+	std::lock_guard<BufMutex> lock(registryMutex);
+	if(pools.count(name) > 0) {
+		throw PoolExistsException(name);
+	}
+	pools[name] = new BufMgr(bufs);
+}
+
+BufMgr* BufPoolRegistry::getPool(const std::string& name)
+{
+	std::lock_guard<BufMutex> lock(registryMutex);
+	return findPool(name);
+}
+
+BufMgr* BufPoolRegistry::findPool(const std::string& name)
+{
+	std::map<std::string, BufMgr*>::iterator it = pools.find(name);
+	if(it == pools.end()) {
+		throw PoolNotFoundException(name);
+	}
+	return it->second;
+}
+
+/*
+ * Binds the file to a pool. Pages of the file that are still sitting in the old pool have to go first,
+ * otherwise the two pools would each hold their own copy of the same page.
+ */
+void BufPoolRegistry::bindFile(const File* file, const std::string& name)
+{
+	std::lock_guard<BufMutex> lock(registryMutex);
+	BufMgr* pool = findPool(name);
+	BufMgr* oldPool = boundPool(file);
+
+	if(oldPool != pool) {
+		//the checksums are in the file's checksum file, which the new pool picks up from here
+		oldPool->flushFile(file);
+	}
+
+	if(pool == defaultPool) {
+		fileBindings.erase(file);
+	}
+	else {
+		fileBindings[file] = pool;
+	}
+}
+
+void BufPoolRegistry::unbindFile(const File* file)
+{
+	bindFile(file, DEFAULT_POOL);
+}
+
+BufMgr* BufPoolRegistry::poolFor(const File* file)
+{
+	std::lock_guard<BufMutex> lock(registryMutex);
+	return boundPool(file);
+}
+
+BufMgr* BufPoolRegistry::boundPool(const File* file)
+{
+	std::map<const File*, BufMgr*>::iterator it = fileBindings.find(file);
+	if(it == fileBindings.end()) {
+		return defaultPool;
+	}
+	return it->second;
+}
+
+void BufPoolRegistry::readPage(File* file, const PageId pageNo, Page*& page)
+{
+	poolFor(file)->readPage(file, pageNo, page);
+}
+
+void BufPoolRegistry::unPinPage(File* file, const PageId pageNo, const bool dirty)
+{
+	poolFor(file)->unPinPage(file, pageNo, dirty);
+}
+
+void BufPoolRegistry::allocPage(File* file, PageId &pageNo, Page*& page)
+{
+	poolFor(file)->allocPage(file, pageNo, page);
+}
+
+void BufPoolRegistry::flushFile(const File* file)
+{
+	poolFor(file)->flushFile(file);
+}
+
+void BufPoolRegistry::disposePage(File* file, const PageId pageNo)
+{
+	poolFor(file)->disposePage(file, pageNo);
+}
+
+void BufPoolRegistry::printSelf()
+{
+	std::lock_guard<BufMutex> lock(registryMutex);
+	for(std::map<std::string, BufMgr*>::iterator it = pools.begin(); it != pools.end(); ++it) {
+		std::cout << "Pool:" << it->first << "\n";
+		it->second->printSelf();
+	}
+}
+
+}
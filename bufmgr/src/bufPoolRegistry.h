@@ -0,0 +1,157 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include "bufConfig.h"
+#include "buffer.h"
+
+namespace badgerdb {
+
+/**
+* @brief Keeps a set of named buffer pools and routes page requests for a file to the pool the file is bound to.
+*
+* Files that were never bound go to the default pool. Binding a file to its own pool keeps a large scan over that
+* file from evicting pages that belong to files in other pools.
+*
+* The registry can be used from several threads. Pools are only ever added, so a pool returned by getPool() or
+* poolFor() stays valid until the registry is destroyed.
+*/
+class BufPoolRegistry
+{
+ private:
+  /**
+   * Buffer pools owned by the registry, keyed by name
+   */
+  std::map<std::string, BufMgr*> pools;
+
+  /**
+   * Pool each bound file is routed to
+   */
+  std::map<const File*, BufMgr*> fileBindings;
+
+  /**
+   * Pool used for files that are not bound to any pool
+   */
+  BufMgr* defaultPool;
+
+  /**
+   * Protects pools and fileBindings. Held while a file moves between pools, so nobody routes a page of the file
+   * to the pool it is leaving, but never while a page is read or written through a pool.
+   */
+  BufMutex registryMutex;
+
+  /**
+   * getPool() for a caller holding registryMutex
+   */
+  BufMgr* findPool(const std::string& name);
+
+  /**
+   * poolFor() for a caller holding registryMutex
+   */
+  BufMgr* boundPool(const File* file);
+
+  BufPoolRegistry(const BufPoolRegistry&) = delete;
+  BufPoolRegistry& operator=(const BufPoolRegistry&) = delete;
+
+ public:
+  /**
+   * Name under which the default pool is registered
+   */
+  static const std::string DEFAULT_POOL;
+
+  /**
+   * Constructor of BufPoolRegistry class. Creates the default pool.
+   *
+   * @param defaultBufs	Number of frames in the default pool
+   */
+  BufPoolRegistry(std::uint32_t defaultBufs);
+
+  /**
+   * Destructor of BufPoolRegistry class. Deletes every pool, which writes out their dirty pages,
+   * so all files that still have pages in a pool must remain open until then.
+   */
+  ~BufPoolRegistry();
+
+  /**
+   * Creates a new named buffer pool.
+   *
+   * @param name   	Name of the pool
+   * @param bufs   	Number of frames in the pool
+   * @throws PoolExistsException If a pool with this name already exists
+   */
+  void createPool(const std::string& name, std::uint32_t bufs);
+
+  /**
+   * Returns the pool registered under the given name.
+   *
+   * @param name   	Name of the pool
+   * @throws PoolNotFoundException If there is no pool with this name
+   */
+  BufMgr* getPool(const std::string& name);
+
+  /**
+   * Routes all further page requests for the file to the named pool. If the file was bound to a different
+   * pool its pages are flushed out of that pool first.
+   *
+   * @param file   	File object
+   * @param name   	Name of the pool
+   * @throws PoolNotFoundException If there is no pool with this name
+   * @throws PagePinnedException If a page of the file is still pinned in the pool it is leaving
+   */
+  void bindFile(const File* file, const std::string& name);
+
+  /**
+   * Routes the file back to the default pool, flushing its pages out of the pool it was bound to.
+   *
+   * @param file   	File object
+   * @throws PagePinnedException If a page of the file is still pinned in the pool it is leaving
+   */
+  void unbindFile(const File* file);
+
+  /**
+   * Returns the pool serving the given file.
+   *
+   * @param file   	File object
+   */
+  BufMgr* poolFor(const File* file);
+
+  /**
+   * Reads a page through the pool the file is bound to. See BufMgr::readPage.
+   */
+  void readPage(File* file, const PageId pageNo, Page*& page);
+
+  /**
+   * Unpins a page in the pool the file is bound to. See BufMgr::unPinPage.
+   */
+  void unPinPage(File* file, const PageId pageNo, const bool dirty);
+
+  /**
+   * Allocates a page in the pool the file is bound to. See BufMgr::allocPage.
+   */
+  void allocPage(File* file, PageId &pageNo, Page*& page);
+
+  /**
+   * Flushes the file out of the pool it is bound to. See BufMgr::flushFile.
+   */
+  void flushFile(const File* file);
+
+  /**
+   * Disposes a page through the pool the file is bound to. See BufMgr::disposePage.
+   */
+  void disposePage(File* file, const PageId pageNo);
+
+  /**
+   * Print every pool.
+   */
+  void printSelf();
+};
+
+}
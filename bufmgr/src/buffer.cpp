@@ -7,21 +7,83 @@
 
 #include <memory>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <map>
+#include <chrono>
 #include "buffer.h"
+#include "crc32c.h"
+#include "pageImage.h"
 #include "exceptions/buffer_exceeded_exception.h"
 #include "exceptions/page_not_pinned_exception.h"
 #include "exceptions/page_pinned_exception.h"
 #include "exceptions/bad_buffer_exception.h"
 #include "exceptions/hash_not_found_exception.h"
+#include "exceptions/invalid_page_exception.h"
+#include "exceptions/grant_pinned_exception.h"
+#include "exceptions/page_checksum_exception.h"
+#include "exceptions/flash_cache_exception.h"
+#include "exceptions/checksum_file_exception.h"
+#include "exceptions/latch_not_held_exception.h"
 
 namespace badgerdb { 
+
+namespace {
+
+/*
+ * CRC32C of the bytes the page is stored as
+ */
+std::uint32_t pageChecksum(const Page& page)
+{
+	char image[Page::SIZE];
+	pageToImage(page, image);
+	return crc32c(image, Page::SIZE);
+}
+
+/*
+ * Lets go of a mutex held by the caller for as long as it lives, if asked to
+ */
+template<class Mutex>
+class MutexUnlock
+{
+ private:
+	Mutex& mutex;
+	bool released;
+
+ public:
+	MutexUnlock(Mutex& mutexIn, bool release)
+		: mutex(mutexIn), released(release)
+	{
+		if(released) {
+			mutex.unlock();
+		}
+	}
+
+	~MutexUnlock()
+	{
+		if(released) {
+			mutex.lock();
+		}
+	}
+};
+
+}
+
 /*
  * Constructs a buffer of size bufs. 
  * Initializes metadata information in bufDescTable.
  * Creates the buffer hash table.
  */
-BufMgr::BufMgr(std::uint32_t bufs) 
-	: numBufs(bufs) {
+template<class Replacement, class Latching>
+BasicBufMgr<Replacement, Latching>::BasicBufMgr(std::uint32_t bufs) 
+	: numBufs(bufs), policy(bufs), latencyTracking(false), frameWaitTimeout(0), nextWaitTicket(0),
+	  reservedFrames(0), unreservedPinned(0), unreservedHeadroom(0), disposeBatch(0),
+	  cleanVictimSearch(0), writeQueueLimit(0), writerRunning(false),
+	  checksumsEnabled(true), doubleWrite(NULL), doubleWriteFlushing(false), doubleWriteRunning(false), secondTier(NULL),
+	  flashCache(NULL) {
 	bufDescTable = new BufDesc[bufs];
 
   for(FrameId i = 0; i < bufs; i++) 
@@ -34,22 +96,60 @@ BufMgr::BufMgr(std::uint32_t bufs)
 
 	int htsize = ((((int) (bufs * 1.2))*2)/2)+1;
   hashTable = new BufHashTbl (htsize);  // allocate the buffer hash table
-
-  clockHand = bufs - 1;
 }
 
 /*
  * Destructor for the BufMgr class.
  * Flushes out all valid dirty pages before deleting buffer pool 
  */	
-BufMgr::~BufMgr() {
+template<class Replacement, class Latching>
+BasicBufMgr<Replacement, Latching>::~BasicBufMgr() {
+
+  //the writer takes bufMutex for every page, and only stops once it has nothing left to write
+  if(writerDrain.valid()) {
+  	writerDrain.wait();
+  }
+
+  //disposed pages still have to leave their files, like dirty pages have to reach them
+  if(disposeDrain.valid()) {
+  	disposeDrain.wait();
+  }
+  try {
+  	deletePages(disposeQueue);
+  } catch(BadgerDbException& e) {
+  }
   
-  //Flushing out all valid, dirty pages
-  for(std::uint32_t i = 0; i < numBufs; i++) { 
-  	if(bufDescTable[i].dirty && bufDescTable[i].valid) {
-		bufDescTable[i].file->writePage(bufPool[i]);
-		bufDescTable[i].dirty = false;
+  //remember what was resident so the next run can warm up from it
+  if(!residentListPath.empty()) {
+  	saveResidentPages(residentListPath);
+  }
+
+  //Flushing out all valid, dirty pages and cutting the links of references that outlive us
+  {
+  	//a full double-write batch is written by a background task, which takes bufMutex
+  	std::lock_guard<Latching> lock(bufMutex);
+  	for(std::uint32_t i = 0; i < numBufs; i++) { 
+  		if(bufDescTable[i].swizzledRef != NULL) {
+			bufDescTable[i].swizzledRef->bufMgr = NULL;
+  		}
+  		if(bufDescTable[i].dirty && bufDescTable[i].valid) {
+			writeToDisk(i);
+  		}
   	}
+  	try {
+  		flushDoubleWrite();
+  	} catch(BadgerDbException& e) {
+  	}
+  }
+  //a task started by the write-backs above finds nothing left to write
+  if(doubleWriteDrain.valid()) {
+  	doubleWriteDrain.wait();
+  }
+  delete doubleWrite;
+  delete secondTier;
+  delete flashCache;
+  for(std::map<const File*, ChecksumFile*>::iterator it = checksumFiles.begin(); it != checksumFiles.end(); ++it) {
+  	delete it->second;
   }
 
   //Deallocating the buffer pool
@@ -60,222 +160,1995 @@ BufMgr::~BufMgr() {
 }
 
 /*
- * Advances the clockhand one space in the buffer pool ahead (with wrap-around).
- * Used in the allocBuf to find a valid frame.
+ * Clears the frame for the next page. The hits the frame collected while holding its page
+ * are credited to the page's file here rather than on every hit.
  */
-void BufMgr::advanceClock()
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::clearFrame(FrameId frameNo)
 {
-	// clockHand is a pointer into the bufPool and bufDescTable and both of these should be changed
-	clockHand = (clockHand + 1) % numBufs;
+	BufDesc& desc = bufDescTable[frameNo];
+	if(desc.valid && desc.hitCnt > 0) {
+		bufStats.files[desc.file->filename()].hits += desc.hitCnt;
+	}
+
+	//disposePage does not care whether the page is pinned
+	if(desc.pinCnt > 0) {
+		unchargeFrame(frameNo);
+	}
+
+	//the reference pointing here has to go back to looking the page up
+	if(desc.swizzledRef != NULL) {
+		desc.swizzledRef->bufMgr = NULL;
+	}
+
+	//optimistic readers of the old page must not validate against the new one
+	desc.latch.bumpVersion();
+	desc.changeCount++;
+	desc.Clear();
+	policy.clear(frameNo);
 }
 
-/*
- * Finds a free frame in the buffer pool using the clock algorithm.
- * Returns the result by reference in frame variable
- */
-void BufMgr::allocBuf(FrameId& frame) 
+template<class Replacement, class Latching>
+Page BasicBufMgr<Replacement, Latching>::readFromDisk(File* file, const PageId pageNo, bool releaseMutex)
 {
-	//implement the clock algorithm here
-	
-	//walk through the bufDescTable starting from where ever the current clockHand is
-	std::uint32_t numPinned = 0;
-	advanceClock();
-	
-	//keep going until we find an invalid page
-	while(bufDescTable[clockHand].valid) {
-		
-		//reset the refbit if necessary then move onto the next frame
-		if(bufDescTable[clockHand].refbit) {
-			bufDescTable[clockHand].refbit = false;
-			advanceClock();
-			continue;
-		}
+	//a page still waiting in the double-write batch is newer than the copy in the file
+	Page page;
+	if(doubleWrite != NULL && doubleWrite->find(file, pageNo, page)) {
+		return page;
+	}
 
-		//cant use this page because it is pinned. If every page is pinned, throw an exception
-		if(bufDescTable[clockHand].pinCnt > 0) {
-			if(++numPinned == numBufs) throw BufferExceededException();
-			advanceClock();
-			continue;
+	LatencyTimer timer(latencyTracking);
+	CompressedPageStore* store = storeFor(file);
+	{
+		//the file mutex goes before bufMutex is taken back, so nobody waits for bufMutex holding a file mutex
+		MutexUnlock<Latching> unlocked(bufMutex, releaseMutex);
+		std::lock_guard<Latching> io(fileMutex(file));
+		if(store == NULL || !store->readPage(pageNo, page)) {
+			page = file->readPage(pageNo);
 		}
+		//the read alone, not the wait for bufMutex after it; recorded once bufMutex is held again
+		timer.mark();
+	}
+	timer.stop(bufLatency.fileRead);
+
+	bufStats.diskreads++;
+	std::uint32_t expected;
+	if(!verifyChecksum(file, pageNo, page, expected)) {
+		throw PageChecksumException(file->filename(), pageNo, expected, pageChecksum(page));
+	}
+	return page;
+}
 
-		//if we get to this point we know the page is valid and not pinned
-		//so write it if it is dirty then use the page (break from the loop as we are done searching)
-		if(bufDescTable[clockHand].dirty) {
-			bufDescTable[clockHand].file->writePage(bufPool[clockHand]);
-			bufDescTable[clockHand].dirty = false;
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::writeToDisk(FrameId frameNo)
+{
+	LatencyTimer timer(latencyTracking);
+	CompressedPageStore* store = storeFor(bufDescTable[frameNo].file);
+	if(store != NULL) {
+		std::lock_guard<Latching> io(fileMutex(bufDescTable[frameNo].file));
+		store->writePage(bufPool[frameNo]);
+	}
+	else if(doubleWrite != NULL) {
+		doubleWrite->add(bufDescTable[frameNo].file, bufPool[frameNo]);
+		if(doubleWrite->full()) {
+			if(!LatchingTraits<Latching>::threaded) {
+				flushDoubleWrite();
+			}
+			else if(!doubleWriteRunning) {
+				//our caller may count on bufMutex staying held, so the batch is written by someone else
+				doubleWriteRunning = true;
+				doubleWriteDrain = std::async(std::launch::async, [this]() {
+					std::lock_guard<Latching> lock(bufMutex);
+					try {
+						while(doubleWrite != NULL && doubleWrite->full()) {
+							flushDoubleWrite();
+						}
+					} catch(BadgerDbException& e) {
+						//the pages went back into the batch, the next flushFile() runs into the error and reports it
+					}
+					doubleWriteRunning = false;
+				});
+			}
 		}
-		hashTable->remove(bufDescTable[clockHand].file, bufDescTable[clockHand].pageNo);
-		break;
 	}
-	//once we break from the loop we know we found a free page where the clockHand is so use it!
-	//Set is called in readPage() and allocPage() when we have the file and pageNo
-	bufDescTable[clockHand].Clear();
-	
-	frame = clockHand;
+	else {
+		std::lock_guard<Latching> io(fileMutex(bufDescTable[frameNo].file));
+		bufDescTable[frameNo].file->writePage(bufPool[frameNo]);
+	}
+	timer.stop(bufLatency.fileWrite);
+
+	markWritten(frameNo, bufPool[frameNo]);
 }
 
-/*
- * Get page pageNo from file and return the result in page variable by reference
- */	
-void BufMgr::readPage(File* file, const PageId pageNo, Page*& page)
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::markWritten(FrameId frameNo, const Page& image)
 {
-	FrameId frameNo;
-	try {
-		//is the page in the buffer pool? If not this function will throw a HashNotFoundException
-		hashTable->lookup(file, pageNo, frameNo);
+	bufDescTable[frameNo].dirty = false;
+	bufDescTable[frameNo].changeCount++;
+	bufStats.diskwrites++;
 
-		//if that line doesn't throw an exception then the page was already in the buffer
-		page = &bufPool[frameNo];
+	if(flashCache != NULL) {
+		flashCache->erase(bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+	}
 
-		//this page was just referenced and someone is using it so increase the count
-		bufDescTable[frameNo].refbit = true;
-		bufDescTable[frameNo].pinCnt++;
-	} catch(HashNotFoundException& e) {
-		try {
-			allocBuf(frameNo);
-			Page tempPage = file->readPage(pageNo);
-			bufPool[frameNo] = tempPage;
-			
-			hashTable->insert(file, pageNo, frameNo);
-			bufDescTable[frameNo].Set(file, pageNo);
+	//the CRC goes out right behind its page, an old one would not match what was just written
+	if(checksumsEnabled) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::uint32_t crc = pageChecksum(image);
+		bufStats.checksumsComputed++;
+		bufStats.checksumNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		checksumsFor(bufDescTable[frameNo].file, true)->record(bufDescTable[frameNo].pageNo, crc);
+	}
+	else {
+		forgetChecksum(bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+	}
+}
 
-			//tempPage will lose scope and we need to update page to point to the newly allocated page
-			page = &bufPool[frameNo];
-		} catch(BufferExceededException& e) {
-			//what to do here!? PANIC!!
-		}
+template<class Replacement, class Latching>
+bool BasicBufMgr<Replacement, Latching>::verifyChecksum(File* file, const PageId pageNo, const Page& page, std::uint32_t& expected)
+{
+	if(!checksumsEnabled) {
+		return true;
+	}
+
+	ChecksumFile* checksums = checksumsFor(file, false);
+	if(checksums == NULL || !checksums->lookup(pageNo, expected)) {
+		return true;
 	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool match = pageChecksum(page) == expected;
+	bufStats.checksumsVerified++;
+	bufStats.checksumNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	if(!match) {
+		bufStats.checksumFailures++;
+	}
+	return match;
 }
 
 /*
- * Decrease the pin count for the specified page in the specified file.
- * If the page is dirty then we need to write that page to disk.
+ * The batch changes hands under bufMutex, and a page written in place is written under its file's mutex like
+ * any other write, so the fsyncs hold neither. Until endFlush() misses find the pages of the batch in it rather
+ * than in their files, and a page of it is not deleted before it is written, see disposePage().
  */
-void BufMgr::unPinPage(File* file, const PageId pageNo, const bool dirty) 
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::flushDoubleWrite()
 {
-	FrameId frameNo;
+	//the batch being written may hold what our caller needs on disk as well
+	while(doubleWriteFlushing) {
+		doubleWriteDone.wait(bufMutex);
+	}
+	if(doubleWrite == NULL || doubleWrite->size() == 0) {
+		return;
+	}
+
+	DoubleWriteBuffer* area = doubleWrite;
+	std::uint32_t count = area->beginFlush();
+	doubleWriteFlushing = true;
 	try {
-		//try to lookup the page in the hashtable
-		hashTable->lookup(file, pageNo, frameNo);
-		
-		//cant unpin a page that isnt pinned
-		if(bufDescTable[frameNo].pinCnt == 0) {
-			throw PageNotPinnedException(file->filename(), pageNo, frameNo);
-		}
-		else {
-			//else decrease the count and update the dirty bit if that page was dirty
-			bufDescTable[frameNo].pinCnt--;
-			if(dirty) {
-				bufDescTable[frameNo].dirty = true;
-			}
+		MutexUnlock<Latching> unlocked(bufMutex, LatchingTraits<Latching>::threaded);
+		area->writeArea();
+		for(std::uint32_t i = 0; i < count; i++) {
+			std::lock_guard<Latching> io(fileMutex(area->flushingFile(i)));
+			area->writeInPlace(i);
 		}
-	//if the page isnt there we dont need to worry about unpinning it
-	} catch(HashNotFoundException& e) {
-		//what to do here!? PANIC!!
+		area->syncFiles();
+		area->writeMarker();
+	} catch(BadgerDbException& e) {
+		area->cancelFlush();
+		doubleWriteFlushing = false;
+		doubleWriteDone.notify_all();
+		throw;
+	}
+	area->endFlush();
+	doubleWriteFlushing = false;
+	doubleWriteDone.notify_all();
+	bufStats.doubleWritePages += count;
+	bufStats.doubleWriteFlushes++;
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::setSecondTier(std::size_t bytes)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	delete secondTier;
+	secondTier = bytes == 0 ? NULL : new CompressedCache(bytes);
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::setFlashCache(const std::string& path, std::uint32_t pages)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	delete flashCache;
+	flashCache = NULL;
+
+	if(!path.empty()) {
+		flashCache = new FlashCache(path, pages);
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::setCompressedStore(const File* file, CompressedPageStore* store)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	//the background writer may still be writing to the old store
+	std::lock_guard<Latching> io(fileMutex(file));
+	if(store == NULL) {
+		compressedStores.erase(file);
+	}
+	else {
+		compressedStores[file] = store;
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::setDoubleWrite(const std::string& path, std::uint32_t pages)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	flushDoubleWrite();
+	delete doubleWrite;
+	doubleWrite = NULL;
+
+	if(!path.empty()) {
+		doubleWrite = new DoubleWriteBuffer(path, pages);
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::forgetChecksum(File* file, const PageId pageNo)
+{
+	ChecksumFile* checksums = checksumsFor(file, false);
+	if(checksums != NULL) {
+		checksums->forget(pageNo);
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::forgetChecksums(const File* file)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	ChecksumFile* checksums = checksumsFor(file, false);
+	if(checksums != NULL) {
+		checksums->clear();
 	}
 }
 
 /*
- * Flush out all pages belonging to specified file.
+ * A file without a checksum file is remembered as such, so reads of it do not look for one every time.
  */
-void BufMgr::flushFile(const File* file) 
+template<class Replacement, class Latching>
+ChecksumFile* BasicBufMgr<Replacement, Latching>::checksumsFor(const File* file, bool create)
 {
-	for(FrameId i = 0; i < numBufs; i++) {
-		//only looking for pages that belong to the file
-		if(bufDescTable[i].file == file) {
-			//throw exceptions
-			
-			//we dont want to write invalid data
-			if(!bufDescTable[i].valid) {
-				throw BadBufferException(bufDescTable[i].frameNo, bufDescTable[i].dirty, bufDescTable[i].valid, bufDescTable[i].refbit);
-				continue;
-			}
-			//and we dont want to write pages that still pinned
-			if(bufDescTable[i].pinCnt > 0) {
-				throw PagePinnedException(file->filename(), bufDescTable[i].pageNo, bufDescTable[i].frameNo);
-				continue;
-			}
-			
-			//write if dirty
-			if(bufDescTable[i].dirty) {
-				bufDescTable[i].file->writePage(bufPool[i]);
-				bufDescTable[i].dirty = false;
-			}
-			
-			//remove the page from the hashtable
-			hashTable->remove(file, bufDescTable[i].pageNo);
-			
-			//clear the metedata 
-			bufDescTable[i].Clear();
-		}	
+	std::map<const File*, ChecksumFile*>::iterator it = checksumFiles.find(file);
+	if(it == checksumFiles.end()) {
+		ChecksumFile* checksums = ChecksumFile::exists(file->filename()) ? new ChecksumFile(file->filename()) : NULL;
+		it = checksumFiles.insert(std::make_pair(file, checksums)).first;
+	}
+	if(it->second == NULL && create) {
+		it->second = new ChecksumFile(file->filename());
+	}
+	return it->second;
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::closeChecksums(const File* file)
+{
+	std::map<const File*, ChecksumFile*>::iterator it = checksumFiles.find(file);
+	if(it != checksumFiles.end()) {
+		delete it->second;
+		checksumFiles.erase(it);
 	}
 }
 
 /*
- * Looks for a frame in which to allocate a page for the specified file. 
- * Returns by reference the page number and pointer to the actual page in the buffer pool
+ * Finds a free frame in the buffer pool using the replacement policy.
+ * Returns the result by reference in frame variable
  */
-void BufMgr::allocPage(File* file, PageId &pageNo, Page*& page) 
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::takeVictim(FrameId& frame) 
 {
-	FrameId frameNo;
+	LatencyTimer timer(latencyTracking);
 
-	//allocate a new page for the file and set the pageNo
-	Page newPage = file->allocatePage();
-	pageNo = newPage.page_number();
+	//a dirty page is left to the writer while a clean one may still turn up close by
+	//If every page is pinned, throw an exception
+	std::uint32_t examined;
+	FrameId found;
+	bool picked = policy.victim([this](FrameId candidate) {
+		if(!bufDescTable[candidate].valid || !bufDescTable[candidate].dirty) {
+			return false;
+		}
+		if(!bufDescTable[candidate].writeQueued) {
+			if(writeQueue.size() >= writeQueueLimit) {
+				return false;
+			}
+			queueWrite(candidate);
+			bufStats.cleanVictimSkips++;
+		}
+		return true;
+	}, cleanVictimSearch, found, examined);
+	if(!picked) {
+		throw BufferExceededException();
+	}
 
-	//put it in the buffer and have it set the frameNo
-	allocBuf(frameNo);
+	//a valid page is written if it is dirty before we use the frame
+	if(bufDescTable[found].valid) {
+		evictFrame(found);
+	}
+	//the frame is free now so use it!
+	//Set is called in readPage() and allocPage() when we have the file and pageNo
+	clearFrame(found);
 
-	//insert this new page into the hashTable and the buffer pool at whatever frame it gave us
-	hashTable->insert(file, pageNo, frameNo);
-	bufPool[frameNo] = newPage;
+	//bucket i holds sweeps of 2^i to 2^(i+1) - 1 frames
+	int bucket = 0;
+	while((examined >> (bucket + 1)) != 0 && bucket < BufStats::SWEEP_BUCKETS - 1) {
+		bucket++;
+	}
+	bufStats.sweepLengths[bucket]++;
 
-	//update the metadata for the frame that now contains a newly allocated page
-	bufDescTable[frameNo].Set(file, pageNo);
+	timer.stop(bufLatency.allocBuf);
+	
+	frame = found;
+}
 
-	//return the page to the caller
-	page = &bufPool[frameNo]; 
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::evictFrame(FrameId frameNo)
+{
+	if(bufDescTable[frameNo].dirty) {
+		writeToDisk(frameNo);
+		bufStats.dirtyEvictions++;
+	}
+	if(secondTier != NULL && secondTier->put(bufDescTable[frameNo].file, bufPool[frameNo])) {
+		bufStats.secondTierStores++;
+	}
+	if(flashCache != NULL) {
+		try {
+			flashCache->admit(bufDescTable[frameNo].file, bufPool[frameNo]);
+			bufStats.flashAdmits++;
+		} catch(FlashCacheException& e) {
+			//a cache that cannot be written only costs us hits
+		}
+	}
+	hashTable->remove(bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo);
+	bufStats.evictions++;
+	clearFrame(frameNo);
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::allocRun(std::uint32_t runFrames, FrameId& head)
+{
+	if(!policy.victimRun(runFrames, head)) {
+		throw BufferExceededException();
+	}
+
+	for(FrameId i = head; i < head + runFrames; i++) {
+		if(bufDescTable[i].valid) {
+			evictFrame(i);
+		}
+		else {
+			clearFrame(i);
+		}
+	}
 }
 
 /*
- * Gets rid of the specified page according to the page number from the specified file
+ * A grant may pin as many frames as it reserved. Everyone else shares what is not reserved.
  */
-void BufMgr::disposePage(File* file, const PageId pageNo)
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::checkQuota(BufGrant* grant)
 {
-	FrameId frameNo;
-	
-	//delete the page from the file
-	file->deletePage(pageNo);
-	
-	try {
-		//remove the page from the hashTable if it exists
-		hashTable->lookup(file, pageNo, frameNo);
-		hashTable->remove(file, pageNo);
+	if(!hasQuota(grant)) {
+		throw BufferExceededException();
+	}
+}
 
-		//update the metadata
-		bufDescTable[frameNo].Clear();
-	} catch(HashNotFoundException& e) {
-		//what to do here!? PANIC!!
-		
-	} 
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::chargeFrame(FrameId frameNo, BufGrant* grant)
+{
+	bufDescTable[frameNo].chargedTo = grant;
+	if(grant != NULL) {
+		grant->pinned++;
+	}
+	else {
+		unreservedPinned++;
+	}
 }
 
-void BufMgr::printSelf(void) 
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unchargeFrame(FrameId frameNo)
 {
-  BufDesc* tmpbuf;
-	int validFrames = 0;
-  
-  for(std::uint32_t i = 0; i < numBufs; i++)
-	{
-  	tmpbuf = &(bufDescTable[i]);
-		std::cout << "FrameNo:" << i << " ";
-		tmpbuf->Print();
+	BufGrant* grant = bufDescTable[frameNo].chargedTo;
+	if(grant != NULL) {
+		grant->pinned--;
+	}
+	else {
+		unreservedPinned--;
+	}
+	bufDescTable[frameNo].chargedTo = NULL;
+}
 
-  	if(tmpbuf->valid == true)
-    	validFrames++;
-  }
+/*
+ * Frames already pinned outside of any grant cannot be promised to a new one.
+ */
+template<class Replacement, class Latching>
+BufGrant* BasicBufMgr<Replacement, Latching>::reserveFrames(std::uint32_t frames)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	std::uint32_t unreserved = std::max(unreservedHeadroom, unreservedPinned);
+	if(unreserved > numBufs || frames > numBufs - unreserved - reservedFrames) {
+		throw BufferExceededException();
+	}
 
-	std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
+	reservedFrames += frames;
+	return new BufGrant(frames);
 }
 
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::releaseGrant(BufGrant* grant)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	if(grant->pinned > 0) {
+		throw GrantPinnedException(grant->pinned);
+	}
+
+	reservedFrames -= grant->frames;
+	delete grant;
+}
+
+/*
+ * The frame in the slot may have been taken by the clock since, or still be pinned by the scan.
+ * Either way it leaves the ring and the slot gets a fresh frame from the clock.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::allocRingBuf(BufAccessStrategy* strategy, FrameId& frame, BufGrant* grant)
+{
+	std::uint32_t slot = strategy->next;
+	strategy->next = (strategy->next + 1) % strategy->ringSize;
+
+	if(slot < strategy->frames.size()) {
+		FrameId frameNo = strategy->frames[slot];
+		BufDesc& desc = bufDescTable[frameNo];
+		if(desc.ring == strategy) {
+			//over the quota the ring page is left alone, allocBuf waits for the quota or gives up
+			if(desc.pinCnt == 0 && !policy.isReferenced(frameNo) && hasQuota(grant)) {
+				if(desc.dirty) {
+					writeToDisk(frameNo);
+					bufStats.dirtyEvictions++;
+				}
+				hashTable->remove(desc.file, desc.pageNo);
+				bufStats.evictions++;
+				bufStats.ringReuses++;
+				clearFrame(frameNo);
+				frame = frameNo;
+				return;
+			}
+			desc.ring = NULL;
+		}
+	}
+
+	allocBuf(frame, grant);
+	if(slot < strategy->frames.size()) {
+		strategy->frames[slot] = frame;
+	}
+	else {
+		strategy->frames.push_back(frame);
+	}
+}
+
+template<class Replacement, class Latching>
+BufAccessStrategy* BasicBufMgr<Replacement, Latching>::getAccessStrategy(std::uint32_t ringSize)
+{
+	if(ringSize == 0) {
+		ringSize = 1;
+	}
+	if(ringSize > numBufs) {
+		ringSize = numBufs;
+	}
+	return new BufAccessStrategy(ringSize);
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::freeAccessStrategy(BufAccessStrategy* strategy)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	for(FrameId frameNo : strategy->frames) {
+		if(bufDescTable[frameNo].ring == strategy) {
+			bufDescTable[frameNo].ring = NULL;
+		}
+	}
+	delete strategy;
+}
+
+template<class Replacement, class Latching>
+bool BasicBufMgr<Replacement, Latching>::findFrame(const File* file, const PageId pageNo, FrameId& frameNo)
+{
+	for(;;) {
+		try {
+			hashTable->lookup(file, pageNo, frameNo);
+		} catch(HashNotFoundException& e) {
+			return false;
+		}
+		if(!bufDescTable[frameNo].loading) {
+			return true;
+		}
+
+		//the page may be gone again by the time we wake up, so it is looked up again
+		pageLoaded.wait(bufMutex);
+	}
+}
+
+/*
+ * Gets a frame from the clock, or when every frame is pinned and a wait timeout is set, queues up
+ * until an unpin frees one. Waiters are served in arrival order, and once anyone is queued new
+ * callers queue behind them instead of grabbing the next free frame. The quota is checked before
+ * the clock evicts a page, and a caller over it waits like one that finds every frame pinned,
+ * since only an unpin helps either of them. Without a frame to fill only the quota is waited for,
+ * which is what a hit on an unpinned page needs.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::waitInLine(BufGrant* grant, FrameId* frame)
+{
+	if(frameWaiters.empty()) {
+		try {
+			checkQuota(grant);
+			if(frame != NULL) {
+				takeVictim(*frame);
+			}
+			return;
+		} catch(BufferExceededException& e) {
+			if(frameWaitTimeout.count() == 0) {
+				throw;
+			}
+		}
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point deadline = start + frameWaitTimeout;
+	std::uint64_t ticket = nextWaitTicket++;
+	frameWaiters.push_back(ticket);
+	bufStats.pinWaits++;
+
+	for(;;) {
+		if(frameWaiters.front() == ticket) {
+			//others may have pinned frames under the same quota while we waited
+			try {
+				checkQuota(grant);
+				if(frame != NULL) {
+					takeVictim(*frame);
+				}
+				frameWaiters.pop_front();
+				bufStats.pinWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+				//the next in line may be able to go as well
+				frameFreed.notify_all();
+				return;
+			} catch(BufferExceededException& e) {
+			}
+		}
+
+		if(std::chrono::steady_clock::now() >= deadline) {
+			frameWaiters.erase(std::find(frameWaiters.begin(), frameWaiters.end(), ticket));
+			bufStats.pinWaitTimeouts++;
+			bufStats.pinWaitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			frameFreed.notify_all();
+			throw BufferExceededException();
+		}
+
+		//our caller holds bufMutex through a lock_guard, the wait hands it over while we sleep
+		frameFreed.wait_until(bufMutex, deadline);
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::allocBuf(FrameId& frame, BufGrant* grant)
+{
+	waitInLine(grant, &frame);
+}
+
+/*
+ * Pins page pageNo of file and returns the frame holding it, reading the page in if it is not
+ * already in the buffer pool. A page that has to come from disk is read with bufMutex released,
+ * into a frame that is pinned and marked loading first.
+ */
+template<class Replacement, class Latching>
+FrameId BasicBufMgr<Replacement, Latching>::pinPage(File* file, const PageId pageNo, BufGrant* grant, BufAccessStrategy* strategy)
+{
+	FrameId frameNo;
+	LatencyTimer timer(latencyTracking);
+	bufStats.accesses++;
+
+	//is the page in the buffer pool? If another miss is still reading it in, we wait for it
+	bool admitted = false;
+	for(;;) {
+		if(findFrame(file, pageNo, frameNo)) {
+			//the first pin on a frame decides who pays for it, and has to wait for the quota
+			//in line with the misses; the page may be gone once we had to wait, so it is looked up again
+			if(bufDescTable[frameNo].pinCnt == 0 && (!hasQuota(grant) || (!admitted && !frameWaiters.empty()))) {
+				waitInLine(grant, NULL);
+				admitted = true;
+				continue;
+			}
+			break;
+		}
+
+		bufStats.misses++;
+		bufStats.files[file->filename()].misses++;
+
+		//the quota is checked before a frame is taken, and again by allocBuf after any wait
+		if(strategy != NULL) {
+			allocRingBuf(strategy, frameNo, grant);
+		}
+		else {
+			allocBuf(frameNo, grant);
+		}
+
+		//allocBuf may have waited, and someone else may have read the page in meanwhile;
+		//the frame we got is cleared and simply stays free then, and we look again
+		FrameId loadedFrame;
+		try {
+			hashTable->lookup(file, pageNo, loadedFrame);
+			admitted = true;
+			continue;
+		} catch(HashNotFoundException& e) {
+		}
+
+		bool inMemory = false;
+		if(secondTier != NULL && secondTier->take(file, pageNo, bufPool[frameNo])) {
+			bufStats.secondTierHits++;
+			inMemory = true;
+		}
+		else if(flashCache != NULL && flashCache->lookup(file, pageNo, bufPool[frameNo])) {
+			bufStats.flashHits++;
+			inMemory = true;
+		}
+		
+		hashTable->insert(file, pageNo, frameNo);
+		bufDescTable[frameNo].Set(file, pageNo);
+		policy.assign(frameNo);
+		chargeFrame(frameNo, grant);
+
+		//a ring page is the first the clock takes as well, unless someone else hits it
+		if(strategy != NULL) {
+			bufDescTable[frameNo].ring = strategy;
+			policy.setReferenced(frameNo, false);
+		}
+
+		if(!inMemory) {
+			//the frame is ours now, so the read can do without bufMutex
+			bufDescTable[frameNo].loading = true;
+			try {
+				bufPool[frameNo] = readFromDisk(file, pageNo, true);
+			} catch(BadgerDbException& e) {
+				//the page never made it, so the frame goes back to the clock and anyone waiting looks again
+				hashTable->remove(file, pageNo);
+				clearFrame(frameNo);
+				pageLoaded.notify_all();
+				frameFreed.notify_all();
+				throw;
+			}
+			bufDescTable[frameNo].loading = false;
+			pageLoaded.notify_all();
+		}
+		timer.stop(bufLatency.readMiss);
+		return frameNo;
+	}
+
+	if(bufDescTable[frameNo].pinCnt == 0) {
+		chargeFrame(frameNo, grant);
+	}
+
+	//this page was just referenced and someone is using it so increase the count
+	//the scan coming back to its own ring page does not make it worth keeping
+	if(strategy == NULL || bufDescTable[frameNo].ring != strategy) {
+		policy.setReferenced(frameNo, true);
+	}
+	if(bufDescTable[frameNo].pinCnt++ == 0) {
+		policy.setPinned(frameNo, true);
+	}
+	bufDescTable[frameNo].hitCnt++;
+	bufStats.hits++;
+	timer.stop(bufLatency.readHit);
+	return frameNo;
+}
+
+/*
+ * A swizzled reference already knows its frame, which it keeps for as long as the page stays in it,
+ * so a hit only has to pin. Otherwise the page goes the usual way and the reference gets the frame
+ * if no other reference holds it yet.
+ */
+template<class Replacement, class Latching>
+FrameId BasicBufMgr<Replacement, Latching>::pinRef(PageRef& ref)
+{
+	if(ref.bufMgr == this) {
+		BufDesc& desc = bufDescTable[ref.frameNo];
+		if(desc.pinCnt == 0 && (!frameWaiters.empty() || !hasQuota(NULL))) {
+			//waiting for the quota goes through the lookup, the page may be evicted meanwhile
+			return pinPage(ref.file, ref.pageNo);
+		}
+		if(desc.pinCnt == 0) {
+			chargeFrame(ref.frameNo, NULL);
+		}
+		bufStats.accesses++;
+		bufStats.hits++;
+		policy.setReferenced(ref.frameNo, true);
+		if(desc.pinCnt++ == 0) {
+			policy.setPinned(ref.frameNo, true);
+		}
+		desc.hitCnt++;
+		return ref.frameNo;
+	}
+
+	FrameId frameNo = pinPage(ref.file, ref.pageNo);
+	if(ref.bufMgr == NULL && bufDescTable[frameNo].swizzledRef == NULL) {
+		bufDescTable[frameNo].swizzledRef = &ref;
+		ref.bufMgr = this;
+		ref.frameNo = frameNo;
+	}
+	return frameNo;
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::readPage(PageRef& ref, Page*& page)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	page = &bufPool[pinRef(ref)];
+}
+
+template<class Replacement, class Latching>
+typename BasicBufMgr<Replacement, Latching>::PageHandle BasicBufMgr<Replacement, Latching>::readPage(PageRef& ref, LatchMode mode)
+{
+	FrameId frameNo;
+	{
+		std::lock_guard<Latching> lock(bufMutex);
+		frameNo = pinRef(ref);
+	}
+	bufDescTable[frameNo].latch.lock(mode);
+	return PageHandle(this, frameNo, bufDescTable[frameNo].file, bufDescTable[frameNo].pageNo, &bufPool[frameNo], mode);
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unswizzle(PageRef& ref)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	if(ref.bufMgr == this) {
+		bufDescTable[ref.frameNo].swizzledRef = NULL;
+		ref.bufMgr = NULL;
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::moveSwizzle(PageRef& from, PageRef& to)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	if(from.bufMgr == this) {
+		bufDescTable[from.frameNo].swizzledRef = &to;
+		to.bufMgr = this;
+		to.frameNo = from.frameNo;
+		from.bufMgr = NULL;
+	}
+}
+
+template<class Manager>
+BasicPageRef<Manager>::BasicPageRef(BasicPageRef&& other)
+	: file(other.file), pageNo(other.pageNo), bufMgr(NULL), frameNo(0)
+{
+	//other may be unswizzled by an eviction at any time, the buffer manager has to check under its mutex
+	Manager* owner = other.bufMgr;
+	if(owner != NULL) {
+		owner->moveSwizzle(other, *this);
+	}
+}
+
+template<class Manager>
+BasicPageRef<Manager>& BasicPageRef<Manager>::operator=(BasicPageRef&& other)
+{
+	if(this != &other) {
+		if(bufMgr != NULL) {
+			bufMgr->unswizzle(*this);
+		}
+		file = other.file;
+		pageNo = other.pageNo;
+		Manager* owner = other.bufMgr;
+		if(owner != NULL) {
+			owner->moveSwizzle(other, *this);
+		}
+	}
+	return *this;
+}
+
+template<class Manager>
+BasicPageRef<Manager>::~BasicPageRef()
+{
+	if(bufMgr != NULL) {
+		bufMgr->unswizzle(*this);
+	}
+}
+
+/*
+ * Get page pageNo from file and return the result in page variable by reference
+ */	
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::readPage(File* file, const PageId pageNo, Page*& page)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	page = &bufPool[pinPage(file, pageNo)];
+}
+
+/*
+ * Same as above but the pin is held by the returned handle, which knows its frame and
+ * so can unpin without going back to the hash table.
+ */
+template<class Replacement, class Latching>
+typename BasicBufMgr<Replacement, Latching>::PageHandle BasicBufMgr<Replacement, Latching>::readPage(File* file, const PageId pageNo)
+{
+	return readPage(file, pageNo, LATCH_NONE);
+}
+
+/*
+ * Pins the page under bufMutex and only then waits for the latch, with the mutex released,
+ * so a thread stuck on a latch never holds up the rest of the pool.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::readPage(File* file, const PageId pageNo, Page*& page, LatchMode mode, BufGrant* grant,
+		BufAccessStrategy* strategy)
+{
+	FrameId frameNo;
+	{
+		std::lock_guard<Latching> lock(bufMutex);
+		frameNo = pinPage(file, pageNo, grant, strategy);
+	}
+	bufDescTable[frameNo].latch.lock(mode);
+	page = &bufPool[frameNo];
+}
+
+template<class Replacement, class Latching>
+typename BasicBufMgr<Replacement, Latching>::PageHandle BasicBufMgr<Replacement, Latching>::readPage(File* file, const PageId pageNo, LatchMode mode, BufGrant* grant,
+		BufAccessStrategy* strategy)
+{
+	Page* page;
+	readPage(file, pageNo, page, mode, grant, strategy);
+	return PageHandle(this, frameOf(page), file, pageNo, page, mode);
+}
+
+/*
+ * Misses go into the ring of the scan, see allocRingBuf.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::readPage(File* file, const PageId pageNo, Page*& page, BufAccessStrategy* strategy)
+{
+	readPage(file, pageNo, page, LATCH_NONE, NULL, strategy);
+}
+
+/*
+ * Mapped pages keep their pins in the MappedFile, the pool only counts the access.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::readPage(MappedFile* file, const PageId pageNo, const Page*& page)
+{
+	page = file->pin(pageNo);
+
+	std::lock_guard<Latching> lock(bufMutex);
+	bufStats.accesses++;
+	bufStats.hits++;
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unPinPage(MappedFile* file, const PageId pageNo)
+{
+	file->unpin(pageNo);
+}
+
+/*
+ * Decrease the pin count of the page in the given frame, marking it dirty if asked to.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unPinFrame(FrameId frameNo, const bool dirty)
+{
+	//cant unpin a page that isnt pinned, or a frame that holds no page at all
+	if(bufDescTable[frameNo].pinCnt == 0) {
+		std::string name = bufDescTable[frameNo].file != NULL ? bufDescTable[frameNo].file->filename() : "";
+		throw PageNotPinnedException(name, bufDescTable[frameNo].pageNo, frameNo);
+	}
+
+	//else decrease the count and update the dirty bit if that page was dirty
+	bufDescTable[frameNo].pinCnt--;
+	if(dirty) {
+		bufDescTable[frameNo].dirty = true;
+		bufDescTable[frameNo].changeCount++;
+	}
+
+	if(bufDescTable[frameNo].pinCnt == 0) {
+		policy.setPinned(frameNo, false);
+		unchargeFrame(frameNo);
+	}
+
+	//this frame can be evicted now, which is what anyone waiting in allocBuf is after
+	if(bufDescTable[frameNo].pinCnt == 0 && !frameWaiters.empty()) {
+		frameFreed.notify_all();
+	}
+}
+
+/*
+ * Decrease the pin count for the specified page in the specified file.
+ * If the page is dirty then we need to write that page to disk.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unPinPage(File* file, const PageId pageNo, const bool dirty) 
+{
+	unPinPage(file, pageNo, dirty, LATCH_NONE);
+}
+
+/*
+ * Releases the latch before dropping the pin; the frame cannot be reused while it is still latched.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unPinPage(File* file, const PageId pageNo, const bool dirty, LatchMode mode)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	FrameId frameNo;
+	try {
+		//try to lookup the page in the hashtable
+		hashTable->lookup(file, pageNo, frameNo);
+	} catch(HashNotFoundException& e) {
+		//if the page isnt there we dont need to worry about unpinning it
+		return;
+	}
+
+	//validate before touching the latch, a bad call must not release a latch someone else holds
+	BufDesc& desc = bufDescTable[frameNo];
+	if(desc.pinCnt == 0) {
+		throw PageNotPinnedException(file->filename(), pageNo, frameNo);
+	}
+	if(!desc.latch.held(mode)) {
+		throw LatchNotHeldException(file->filename(), pageNo, mode);
+	}
+	desc.latch.unlock(mode);
+	unPinFrame(frameNo, dirty);
+}
+
+/*
+ * Runs from the handle's destructor, so it must not throw. The handle's pin may already be gone and its frame
+ * reused, in which case the latch and pin count in the frame belong to some other page.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::releaseHandle(const PageHandle& handle) noexcept
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	BufDesc& desc = bufDescTable[handle.frameNo];
+	if(!desc.valid || desc.file != handle.file || desc.pageNo != handle.pageNo || desc.pinCnt == 0) {
+		return;
+	}
+
+	desc.latch.unlock(handle.latchMode);
+	unPinFrame(handle.frameNo, handle.dirty);
+}
+
+/*
+ * The version is taken while the page is still pinned, so it belongs to this page and not
+ * to whatever replaces it once the pin is gone.
+ */
+template<class Replacement, class Latching>
+std::uint64_t BasicBufMgr<Replacement, Latching>::readPageOptimistic(File* file, const PageId pageNo, Page*& page)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	FrameId frameNo = pinPage(file, pageNo);
+	std::uint64_t version = bufDescTable[frameNo].latch.currentVersion();
+	unPinFrame(frameNo, false);
+
+	page = &bufPool[frameNo];
+	return version;
+}
+
+template<class Replacement, class Latching>
+bool BasicBufMgr<Replacement, Latching>::tryUpgradeLatch(Page* page)
+{
+	return bufDescTable[frameOf(page)].latch.tryUpgrade();
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::downgradeLatch(Page* page)
+{
+	bufDescTable[frameOf(page)].latch.downgrade();
+}
+
+/*
+ * Hands the latch and the pin back to the buffer manager they came from, at most once.
+ */
+template<class Manager>
+void BasicPageHandle<Manager>::release() noexcept
+{
+	if(bufMgr != NULL) {
+		bufMgr->releaseHandle(*this);
+		bufMgr = NULL;
+		page = NULL;
+		latchMode = LATCH_NONE;
+	}
+}
+
+template<class Manager>
+bool BasicPageHandle<Manager>::tryUpgrade()
+{
+	if(latchMode != LATCH_SHARED || !bufMgr->tryUpgradeLatch(page)) {
+		return false;
+	}
+	latchMode = LATCH_EXCLUSIVE;
+	return true;
+}
+
+template<class Manager>
+void BasicPageHandle<Manager>::downgrade()
+{
+	if(latchMode == LATCH_EXCLUSIVE) {
+		bufMgr->downgradeLatch(page);
+		latchMode = LATCH_SHARED;
+	}
+}
+
+/*
+ * Flush out all pages belonging to specified file.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::flushFile(const File* file) 
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	//the file may be closed after this, so the writer has to be done with it as well
+	dropQueuedWrites(file);
+
+	for(FrameId i = 0; i < numBufs; i++) {
+		//only looking for pages that belong to the file
+		if(bufDescTable[i].file == file) {
+			//throw exceptions
+			
+			//we dont want to write invalid data
+			if(!bufDescTable[i].valid) {
+				throw BadBufferException(bufDescTable[i].frameNo, bufDescTable[i].dirty, bufDescTable[i].valid, policy.isReferenced(i));
+				continue;
+			}
+			//and we dont want to write pages that still pinned
+			if(bufDescTable[i].pinCnt > 0) {
+				throw PagePinnedException(file->filename(), bufDescTable[i].pageNo, bufDescTable[i].frameNo);
+				continue;
+			}
+			
+			//write if dirty
+			if(bufDescTable[i].dirty) {
+				writeToDisk(i);
+			}
+			
+			//remove the page from the hashtable
+			hashTable->remove(file, bufDescTable[i].pageNo);
+			
+			//clear the metedata 
+			clearFrame(i);
+		}	
+	}
+
+	if(!frameWaiters.empty()) {
+		frameFreed.notify_all();
+	}
+
+	//the file may be closed after this, and its File object reused for another one
+	if(secondTier != NULL) {
+		secondTier->eraseFile(file);
+	}
+	if(flashCache != NULL) {
+		flashCache->eraseFile(file);
+	}
+
+	//the file is only flushed once its pages made it through the double-write area or into its store
+	flushDoubleWrite();
+	CompressedPageStore* store = storeFor(file);
+	if(store != NULL) {
+		std::lock_guard<Latching> io(fileMutex(file));
+		store->sync();
+		//pages the store now holds durably need no copy in the file
+		store->releaseFileCopies(file);
+	}
+	std::map<const File*, ChecksumFile*>::iterator checksums = checksumFiles.find(file);
+	if(checksums != checksumFiles.end() && checksums->second != NULL) {
+		checksums->second->sync();
+	}
+	closeChecksums(file);
+
+	std::uint64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+	bufStats.flushes++;
+	bufStats.flushNanos += nanos;
+	bufStats.maxFlushNanos = std::max(bufStats.maxFlushNanos, nanos);
+}
+
+/*
+ * Allocates a new page in file and pins it in a frame. The page number is returned by reference.
+ */
+template<class Replacement, class Latching>
+FrameId BasicBufMgr<Replacement, Latching>::pinNewPage(File* file, PageId &pageNo, BufGrant* grant)
+{
+	FrameId frameNo;
+	bufStats.accesses++;
+
+	//get the frame first so a full pool does not leave an allocated page behind in the file
+	allocBuf(frameNo, grant);
+
+	//allocate a new page for the file and set the pageNo
+	Page newPage;
+	{
+		std::lock_guard<Latching> io(fileMutex(file));
+		newPage = file->allocatePage();
+	}
+	pageNo = newPage.page_number();
+
+	//the number may be that of a page deleted behind our back, whose CRC is still around
+	forgetChecksum(file, pageNo);
+	bufStats.diskreads++;
+
+	//insert this new page into the hashTable and the buffer pool at whatever frame it gave us
+	hashTable->insert(file, pageNo, frameNo);
+	bufPool[frameNo] = newPage;
+
+	//update the metadata for the frame that now contains a newly allocated page
+	bufDescTable[frameNo].Set(file, pageNo);
+	policy.assign(frameNo);
+	chargeFrame(frameNo, grant);
+
+	return frameNo;
+}
+
+/*
+ * Looks for a frame in which to allocate a page for the specified file. 
+ * Returns by reference the page number and pointer to the actual page in the buffer pool
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::allocPage(File* file, PageId &pageNo, Page*& page) 
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	//return the page to the caller
+	page = &bufPool[pinNewPage(file, pageNo)]; 
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::allocPage(File* file, PageId &pageNo, Page*& page, BufGrant* grant)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	page = &bufPool[pinNewPage(file, pageNo, grant)];
+}
+
+template<class Replacement, class Latching>
+typename BasicBufMgr<Replacement, Latching>::PageHandle BasicBufMgr<Replacement, Latching>::allocPage(File* file, PageId &pageNo, BufGrant* grant)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	FrameId frameNo = pinNewPage(file, pageNo, grant);
+	return PageHandle(this, frameNo, file, pageNo, &bufPool[frameNo], LATCH_NONE);
+}
+
+/*
+ * The frames are taken first, so a pool without enough of them fails before the file has grown.
+ * A frame is held as a valid, pinned frame while the rest are found, which keeps the clock from handing it out twice.
+ * The clock is swept directly instead of through allocBuf, so bufMutex is never let go and nobody else gets to
+ * see such a frame.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::allocPages(File* file, std::uint32_t count, std::vector<PageId>& pageNos, std::vector<Page*>& pages,
+		BufGrant* grant)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	std::vector<FrameId> frames;
+	frames.reserve(count);
+	pageNos.clear();
+	pages.clear();
+
+	try {
+		for(std::uint32_t i = 0; i < count; i++) {
+			//a frame over the quota is refused before the clock evicts a page for it
+			checkQuota(grant);
+			FrameId frameNo;
+			takeVictim(frameNo);
+			bufDescTable[frameNo].valid = true;
+			bufDescTable[frameNo].pinCnt = 1;
+			policy.setValid(frameNo, true);
+			policy.setPinned(frameNo, true);
+			chargeFrame(frameNo, grant);
+			frames.push_back(frameNo);
+		}
+
+		std::lock_guard<Latching> io(fileMutex(file));
+		for(std::vector<FrameId>::iterator it = frames.begin(); it != frames.end(); ++it) {
+			Page newPage = file->allocatePage();
+			PageId pageNo = newPage.page_number();
+			forgetChecksum(file, pageNo);
+			bufStats.accesses++;
+			bufStats.diskreads++;
+
+			hashTable->insert(file, pageNo, *it);
+			bufPool[*it] = newPage;
+
+			//Set keeps the pin count at 1, so the frame stays pinned for the caller
+			bufDescTable[*it].Set(file, pageNo);
+			policy.assign(*it);
+
+			pageNos.push_back(pageNo);
+			pages.push_back(&bufPool[*it]);
+		}
+	} catch(BadgerDbException& e) {
+		//give back what we took: the pages already allocated leave the file again, and clearFrame
+		//returns every frame to the clock along with its charge
+		std::lock_guard<Latching> io(fileMutex(file));
+		for(std::uint32_t i = 0; i < frames.size(); i++) {
+			if(i < pageNos.size()) {
+				hashTable->remove(file, pageNos[i]);
+				try {
+					file->deletePage(pageNos[i]);
+				} catch(BadgerDbException& e) {
+					//the page stays behind in the file, empty and known to nobody
+				}
+			}
+			clearFrame(frames[i]);
+		}
+		pageNos.clear();
+		pages.clear();
+		frameFreed.notify_all();
+		throw;
+	}
+}
+
+/*
+ * Pages of the run that are resident in the wrong frame are copied over, dirty bit and all, instead of
+ * being read again. Run frames are charged to the unreserved part of the pool like any other pin.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::readRun(File* file, const PageId first, std::uint32_t pages, Page*& run)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	std::uint32_t runFrames = 1;
+	while(runFrames < pages) {
+		runFrames <<= 1;
+	}
+	if(pages == 0 || runFrames > numBufs) {
+		throw BufferExceededException();
+	}
+
+	//a page a miss is still reading in cannot be pinned or moved yet, and bufMutex is let go while
+	//waiting for it, so the whole run is looked at again afterwards
+	bool waited;
+	do {
+		waited = false;
+		for(std::uint32_t i = 0; i < pages && !waited; i++) {
+			FrameId frameNo;
+			try {
+				hashTable->lookup(file, first + i, frameNo);
+				if(bufDescTable[frameNo].loading) {
+					pageLoaded.wait(bufMutex);
+					waited = true;
+				}
+			} catch(HashNotFoundException& e) {
+			}
+		}
+	} while(waited);
+
+	//where each page of the run is now, if it is resident
+	std::vector<FrameId> frames(pages);
+	std::vector<bool> resident(pages, false);
+	bool together = true;
+	for(std::uint32_t i = 0; i < pages; i++) {
+		try {
+			hashTable->lookup(file, first + i, frames[i]);
+			resident[i] = true;
+		} catch(HashNotFoundException& e) {
+		}
+		together = together && resident[i] && frames[i] == frames[0] + i;
+	}
+	bufStats.accesses += pages;
+
+	if(together) {
+		std::uint32_t unpinned = 0;
+		for(std::uint32_t i = 0; i < pages; i++) {
+			if(bufDescTable[frames[i]].pinCnt == 0) {
+				unpinned++;
+			}
+		}
+		if(unreservedPinned + unpinned > numBufs - reservedFrames) {
+			throw BufferExceededException();
+		}
+
+		for(std::uint32_t i = 0; i < pages; i++) {
+			if(bufDescTable[frames[i]].pinCnt == 0) {
+				chargeFrame(frames[i], NULL);
+			}
+			if(bufDescTable[frames[i]].pinCnt++ == 0) {
+				policy.setPinned(frames[i], true);
+			}
+			policy.setReferenced(frames[i], true);
+			bufDescTable[frames[i]].hitCnt++;
+		}
+		bufStats.hits += pages;
+		run = &bufPool[frames[0]];
+		return;
+	}
+
+	//a pinned page cannot be moved
+	for(std::uint32_t i = 0; i < pages; i++) {
+		if(resident[i] && bufDescTable[frames[i]].pinCnt > 0) {
+			throw PagePinnedException(file->filename(), first + i, frames[i]);
+		}
+	}
+	if(unreservedPinned + pages > numBufs - reservedFrames) {
+		throw BufferExceededException();
+	}
+
+	FrameId head;
+	allocRun(runFrames, head);
+
+	std::uint32_t filled = 0;
+	try {
+		for(; filled < pages; filled++) {
+			FrameId frameNo = head + filled;
+			bool dirty = false;
+
+			//allocRun may have evicted it, so look again
+			FrameId oldFrame;
+			try {
+				hashTable->lookup(file, first + filled, oldFrame);
+				bufPool[frameNo] = bufPool[oldFrame];
+				dirty = bufDescTable[oldFrame].dirty;
+				hashTable->remove(file, first + filled);
+				clearFrame(oldFrame);
+				bufStats.hits++;
+			} catch(HashNotFoundException& e) {
+				if(secondTier != NULL && secondTier->take(file, first + filled, bufPool[frameNo])) {
+					bufStats.secondTierHits++;
+				}
+				else if(flashCache != NULL && flashCache->lookup(file, first + filled, bufPool[frameNo])) {
+					bufStats.flashHits++;
+				}
+				else {
+					bufPool[frameNo] = readFromDisk(file, first + filled);
+				}
+				bufStats.misses++;
+				bufStats.files[file->filename()].misses++;
+			}
+
+			hashTable->insert(file, first + filled, frameNo);
+			bufDescTable[frameNo].Set(file, first + filled);
+			policy.assign(frameNo);
+			bufDescTable[frameNo].dirty = dirty;
+			chargeFrame(frameNo, NULL);
+		}
+	} catch(BadgerDbException& e) {
+		//the frames filled so far are unpinned again along with their charge; a page moved here with
+		//changes stays resident so they are not lost, the rest go back to the clock
+		for(std::uint32_t i = 0; i < filled; i++) {
+			FrameId frameNo = head + i;
+			if(bufDescTable[frameNo].dirty) {
+				unchargeFrame(frameNo);
+				bufDescTable[frameNo].pinCnt = 0;
+				policy.setPinned(frameNo, false);
+			}
+			else {
+				hashTable->remove(file, first + i);
+				clearFrame(frameNo);
+			}
+		}
+		frameFreed.notify_all();
+		throw;
+	}
+	run = &bufPool[head];
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::unPinRun(File* file, const PageId first, std::uint32_t pages, const bool dirty)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	for(std::uint32_t i = 0; i < pages; i++) {
+		FrameId frameNo;
+		try {
+			hashTable->lookup(file, first + i, frameNo);
+			unPinFrame(frameNo, dirty);
+		} catch(HashNotFoundException& e) {
+			//same as unPinPage, a page that is not there does not need unpinning
+		}
+	}
+}
+
+/*
+ * Gets rid of the specified page according to the page number from the specified file
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::disposePage(File* file, const PageId pageNo)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	FrameId frameNo;
+
+	//a double-write batch being written would write the page back after it was deleted
+	while(doubleWrite != NULL && doubleWrite->inFlight(file, pageNo)) {
+		doubleWriteDone.wait(bufMutex);
+	}
+
+	//an error of the last background batch is reported before anything else happens
+	collectDisposeDrain();
+
+	//someone is still using the page, deleting it would leave them with a frame that is reused under them
+	try {
+		hashTable->lookup(file, pageNo, frameNo);
+		if(bufDescTable[frameNo].pinCnt > 0) {
+			throw PagePinnedException(file->filename(), pageNo, frameNo);
+		}
+	} catch(HashNotFoundException& e) {
+	}
+	
+	//a write of the page that is still on its way would bring it back
+	if(doubleWrite != NULL) {
+		doubleWrite->drop(file, pageNo);
+	}
+	if(secondTier != NULL) {
+		secondTier->erase(file, pageNo);
+	}
+	if(flashCache != NULL) {
+		flashCache->erase(file, pageNo);
+	}
+
+	//delete the page from the file, or leave that to the next batch
+	if(disposeBatch == 0) {
+		std::lock_guard<Latching> io(fileMutex(file));
+		file->deletePage(pageNo);
+		forgetChecksum(file, pageNo);
+		if(storeFor(file) != NULL) {
+			storeFor(file)->erase(pageNo);
+		}
+	}
+	else {
+		disposeQueue.push_back(std::make_pair(file, pageNo));
+	}
+	
+	try {
+		//remove the page from the hashTable if it exists
+		hashTable->lookup(file, pageNo, frameNo);
+		hashTable->remove(file, pageNo);
+
+		//update the metadata
+		clearFrame(frameNo);
+		if(!frameWaiters.empty()) {
+			frameFreed.notify_all();
+		}
+	} catch(HashNotFoundException& e) {
+		//what to do here!? PANIC!!
+		
+	} 
+
+	//hand a full batch to the background, unless the last one is still being deleted or was not collected yet
+	if(disposeBatch > 0 && disposeQueue.size() >= disposeBatch) {
+		if(!LatchingTraits<Latching>::threaded) {
+			//nobody else takes bufMutex, so there is no background to hand it to
+			deletePages(disposeQueue);
+		}
+		else if(!disposeDrain.valid()) {
+			std::vector<std::pair<File*, PageId> > batch;
+			batch.swap(disposeQueue);
+			disposeDrain = std::async(std::launch::async, [this, batch]() mutable {
+				std::lock_guard<Latching> lock(bufMutex);
+				try {
+					deletePages(batch);
+				} catch(BadgerDbException& e) {
+					//deletePages leaves what it did not get to in the batch, the next batch tries again
+					disposeQueue.insert(disposeQueue.end(), batch.begin(), batch.end());
+					throw;
+				}
+			});
+		}
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::collectDisposeDrain()
+{
+	if(disposeDrain.valid() && disposeDrain.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+		std::future<void> done = std::move(disposeDrain);
+		done.get();
+	}
+}
+
+/*
+ * The writer takes bufMutex for one page at a time and lets go of it while the page is written, so
+ * misses get in between and alongside its writes. It notes that it stopped before letting go of
+ * bufMutex, so a frame queued after that starts a new one.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::queueWrite(FrameId frameNo)
+{
+	BufDesc& desc = bufDescTable[frameNo];
+	PageKey key = { desc.file, desc.pageNo };
+	writeQueue.push_back(std::make_pair(frameNo, key));
+	desc.writeQueued = true;
+
+	if(!LatchingTraits<Latching>::threaded) {
+		//nobody else takes bufMutex, so the queue is written back here once it is full
+		if(writeQueue.size() >= writeQueueLimit) {
+			while(!writeQueue.empty()) {
+				writeQueued();
+			}
+		}
+	}
+	else if(!writerRunning) {
+		writerRunning = true;
+		writerDrain = std::async(std::launch::async, [this]() {
+			for(;;) {
+				std::lock_guard<Latching> lock(bufMutex);
+				if(writeQueue.empty()) {
+					writerRunning = false;
+					return;
+				}
+				writeQueued();
+			}
+		});
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::writeQueued()
+{
+	FrameId frameNo = writeQueue.front().first;
+	PageKey key = writeQueue.front().second;
+	writeQueue.pop_front();
+
+	//the frame may have been evicted, or even reused, since it was queued
+	BufDesc& desc = bufDescTable[frameNo];
+	if(!desc.valid || desc.file != key.file || desc.pageNo != key.pageNo) {
+		return;
+	}
+	desc.writeQueued = false;
+	if(!desc.dirty || desc.pinCnt > 0) {
+		return;
+	}
+
+	//the double-write batch is shared by every file, it is only filled and flushed under bufMutex
+	CompressedPageStore* store = storeFor(desc.file);
+	if(store == NULL && doubleWrite != NULL) {
+		try {
+			writeToDisk(frameNo);
+			bufStats.backgroundWrites++;
+		} catch(BadgerDbException& e) {
+			//still dirty, so the write is tried again when the frame is evicted and the error shows up there
+		}
+		return;
+	}
+
+	//a copy is written, the frame may be pinned and changed while bufMutex is let go of
+	LatencyTimer timer(latencyTracking);
+	File* file = desc.file;
+	Page image = bufPool[frameNo];
+	std::uint32_t changes = desc.changeCount;
+	bool written = true;
+	{
+		//taken before bufMutex is let go of, so whoever writes, deletes or reads the page next comes after us
+		std::unique_lock<Latching> io(fileMutex(file));
+		MutexUnlock<Latching> unlocked(bufMutex, true);
+		try {
+			if(store != NULL) {
+				store->writePage(image);
+			}
+			else {
+				file->writePage(image);
+			}
+			timer.mark();
+		} catch(BadgerDbException& e) {
+			//still dirty, so the write is tried again when the frame is evicted and the error shows up there
+			written = false;
+		} catch(...) {
+			io.unlock();
+			throw;
+		}
+		//the file mutex is never held while waiting for bufMutex
+		io.unlock();
+	}
+	timer.stop(bufLatency.fileWrite);
+
+	//dirtied, written or dropped meanwhile, the frame is someone else's to write now
+	if(!written || desc.changeCount != changes) {
+		return;
+	}
+	markWritten(frameNo, image);
+	bufStats.backgroundWrites++;
+}
+
+/*
+ * The writer takes the file's mutex before it lets go of bufMutex and keeps it until the write is done,
+ * so once we got that mutex nothing of the file is being written any more.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::dropQueuedWrites(const File* file)
+{
+	for(typename std::deque<std::pair<FrameId, PageKey> >::iterator it = writeQueue.begin(); it != writeQueue.end(); ) {
+		if(it->second.file == file) {
+			if(bufDescTable[it->first].file == file && bufDescTable[it->first].pageNo == it->second.pageNo) {
+				bufDescTable[it->first].writeQueued = false;
+			}
+			it = writeQueue.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	std::lock_guard<Latching> io(fileMutex(file));
+}
+
+/*
+ * Pages of one file are deleted in page number order, which keeps the free list of the file in order as well.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::deletePages(std::vector<std::pair<File*, PageId> >& batch)
+{
+	std::sort(batch.begin(), batch.end());
+	while(!batch.empty()) {
+		//deleted from the back, so a page that fails does not get deleted a second time by the next try
+		std::lock_guard<Latching> io(fileMutex(batch.back().first));
+		batch.back().first->deletePage(batch.back().second);
+		forgetChecksum(batch.back().first, batch.back().second);
+		if(storeFor(batch.back().first) != NULL) {
+			storeFor(batch.back().first)->erase(batch.back().second);
+		}
+		batch.pop_back();
+	}
+}
+
+/*
+ * Checks every frame of the file before dropping any, so a pinned page leaves the pool as it was.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::disposeFile(const File* file)
+{
+	std::future<void> drain;
+	{
+		std::lock_guard<Latching> lock(bufMutex);
+		drain = std::move(disposeDrain);
+	}
+	//the background batch may hold pages of this file, so it has to be done before the file goes away;
+	//an error it ran into is reported here, before anything is dropped
+	if(drain.valid()) {
+		drain.get();
+	}
+
+	std::lock_guard<Latching> lock(bufMutex);
+	//a double-write batch being written may hold pages of the file, and syncs it by name at the end
+	while(doubleWriteFlushing) {
+		doubleWriteDone.wait(bufMutex);
+	}
+	for(FrameId i = 0; i < numBufs; i++) {
+		if(bufDescTable[i].valid && bufDescTable[i].file == file && bufDescTable[i].pinCnt > 0) {
+			throw PagePinnedException(file->filename(), bufDescTable[i].pageNo, bufDescTable[i].frameNo);
+		}
+	}
+
+	//a background write landing after we returned would hit a file that may be gone
+	dropQueuedWrites(file);
+
+	for(FrameId i = 0; i < numBufs; i++) {
+		if(bufDescTable[i].valid && bufDescTable[i].file == file) {
+			hashTable->remove(file, bufDescTable[i].pageNo);
+			clearFrame(i);
+		}
+	}
+
+	ChecksumFile* checksums = checksumsFor(file, false);
+	if(checksums != NULL) {
+		checksums->clear();
+	}
+	closeChecksums(file);
+	//a rebuilt file would otherwise read the old pages out of the store before its own
+	CompressedPageStore* store = storeFor(file);
+	if(store != NULL) {
+		std::lock_guard<Latching> io(fileMutex(file));
+		store->clear();
+	}
+	if(doubleWrite != NULL) {
+		doubleWrite->dropFile(file);
+	}
+	if(secondTier != NULL) {
+		secondTier->eraseFile(file);
+	}
+	if(flashCache != NULL) {
+		flashCache->eraseFile(file);
+	}
+
+	disposeQueue.erase(std::remove_if(disposeQueue.begin(), disposeQueue.end(),
+			[file](const std::pair<File*, PageId>& entry) { return entry.first == file; }), disposeQueue.end());
+
+	if(!frameWaiters.empty()) {
+		frameFreed.notify_all();
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::setDisposeBatch(std::uint32_t pages)
+{
+	{
+		std::lock_guard<Latching> lock(bufMutex);
+		disposeBatch = pages;
+	}
+	if(pages == 0) {
+		drainDisposeQueue();
+	}
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::setCleanVictimSearch(std::uint32_t distance, std::uint32_t maxQueued)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	cleanVictimSearch = distance;
+	writeQueueLimit = maxQueued;
+}
+
+/*
+ * The background batch takes bufMutex itself, so it is waited for without holding it.
+ */
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::drainDisposeQueue()
+{
+	std::future<void> drain;
+	{
+		std::lock_guard<Latching> lock(bufMutex);
+		drain = std::move(disposeDrain);
+	}
+	if(drain.valid()) {
+		drain.get();
+	}
+
+	std::lock_guard<Latching> lock(bufMutex);
+	deletePages(disposeQueue);
+}
+
+/*
+ * The counters are updated under bufMutex, so they are copied under it too.
+ */
+template<class Replacement, class Latching>
+BufStats BasicBufMgr<Replacement, Latching>::getBufStats()
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	return bufStats;
+}
+
+/*
+ * Copies the statistics and credits the hits of the pages still in the pool to their files.
+ */
+template<class Replacement, class Latching>
+BufStats BasicBufMgr<Replacement, Latching>::getBufStatsSnapshot()
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	BufStats snapshot = bufStats;
+	for(FrameId i = 0; i < numBufs; i++) {
+		if(bufDescTable[i].valid && bufDescTable[i].hitCnt > 0) {
+			snapshot.files[bufDescTable[i].file->filename()].hits += bufDescTable[i].hitCnt;
+		}
+	}
+	return snapshot;
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::clearBufStats()
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	bufStats.clear();
+	for(FrameId i = 0; i < numBufs; i++) {
+		bufDescTable[i].hitCnt = 0;
+	}
+}
+
+template<class Replacement, class Latching>
+BufLatency BasicBufMgr<Replacement, Latching>::getBufLatency()
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	return bufLatency;
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::clearBufLatency()
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	bufLatency.clear();
+}
+
+template<class Replacement, class Latching>
+void BasicBufMgr<Replacement, Latching>::printSelf(void) 
+{
+	std::lock_guard<Latching> lock(bufMutex);
+  BufDesc* tmpbuf;
+	int validFrames = 0;
+  
+  for(std::uint32_t i = 0; i < numBufs; i++)
+	{
+  	tmpbuf = &(bufDescTable[i]);
+		std::cout << "FrameNo:" << i << " ";
+		tmpbuf->Print(policy.isReferenced(i));
+
+  	if(tmpbuf->valid == true)
+    	validFrames++;
+  }
+
+	std::cout << "Total Number of Valid Frames:" << validFrames << "\n";
+}
+
+/*
+ * Writes one line per valid frame: file name, page number and refbit, separated by tabs
+ * (tabs so that file names with spaces survive the round trip).
+ */
+template<class Replacement, class Latching>
+bool BasicBufMgr<Replacement, Latching>::saveResidentPages(const std::string& path)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	std::ofstream out(path.c_str(), std::ios::out | std::ios::trunc);
+	if(!out) {
+		return false;
+	}
+
+	for(FrameId i = 0; i < numBufs; i++) {
+		if(bufDescTable[i].valid) {
+			out << bufDescTable[i].file->filename() << "\t" << bufDescTable[i].pageNo << "\t" << policy.isReferenced(i) << "\n";
+		}
+	}
+	return out.good();
+}
+
+/*
+ * Reloads a resident page list into the free frames of the pool.
+ * Only frames that are not valid are used, warming up never evicts anything.
+ */
+template<class Replacement, class Latching>
+std::uint32_t BasicBufMgr<Replacement, Latching>::warmUp(const std::string& path, const std::vector<File*>& files)
+{
+	std::ifstream in(path.c_str());
+	if(!in) {
+		return 0;
+	}
+
+	std::map<std::string, File*> filesByName;
+	for(std::size_t i = 0; i < files.size(); i++) {
+		filesByName[files[i]->filename()] = files[i];
+	}
+
+	//read the list, dropping entries for files we were not given
+	std::vector<WarmEntry> entries;
+	std::string line;
+	while(std::getline(in, line)) {
+		std::size_t first = line.find('\t');
+		std::size_t second = line.find('\t', first + 1);
+		if(first == std::string::npos || second == std::string::npos) {
+			continue;
+		}
+
+		std::map<std::string, File*>::iterator it = filesByName.find(line.substr(0, first));
+		if(it == filesByName.end()) {
+			continue;
+		}
+
+		WarmEntry entry;
+		std::istringstream fields(line.substr(first + 1));
+		int refbit = 0;
+		if(!(fields >> entry.pageNo >> refbit)) {
+			continue;
+		}
+		entry.file = it->second;
+		entry.refbit = refbit != 0;
+		entries.push_back(entry);
+	}
+
+	//pages that are already resident are dropped, and if not everything fits, the recently referenced pages
+	//are the ones worth having
+	{
+		std::lock_guard<Latching> lock(bufMutex);
+		std::vector<WarmEntry> missing;
+		for(std::size_t i = 0; i < entries.size(); i++) {
+			FrameId frameNo;
+			try {
+				hashTable->lookup(entries[i].file, entries[i].pageNo, frameNo);
+			} catch(HashNotFoundException& e) {
+				missing.push_back(entries[i]);
+			}
+		}
+		entries.swap(missing);
+
+		std::size_t freeFrames = 0;
+		for(FrameId i = 0; i < numBufs; i++) {
+			if(!bufDescTable[i].valid) {
+				freeFrames++;
+			}
+		}
+		if(entries.size() > freeFrames) {
+			std::stable_sort(entries.begin(), entries.end(),
+					[](const WarmEntry& a, const WarmEntry& b) { return a.refbit && !b.refbit; });
+			entries.resize(freeFrames);
+		}
+	}
+
+	//one reader per file, each reading its pages in page number order
+	std::map<File*, std::vector<WarmEntry> > entriesByFile;
+	for(std::size_t i = 0; i < entries.size(); i++) {
+		entriesByFile[entries[i].file].push_back(entries[i]);
+	}
+
+	std::vector<std::future<std::uint32_t> > readers;
+	std::uint32_t loaded = 0;
+	for(typename std::map<File*, std::vector<WarmEntry> >::iterator it = entriesByFile.begin(); it != entriesByFile.end(); ++it) {
+		std::vector<WarmEntry>& fileEntries = it->second;
+		std::sort(fileEntries.begin(), fileEntries.end(),
+				[](const WarmEntry& a, const WarmEntry& b) { return a.pageNo < b.pageNo; });
+		fileEntries.erase(std::unique(fileEntries.begin(), fileEntries.end(),
+				[](const WarmEntry& a, const WarmEntry& b) { return a.pageNo == b.pageNo; }), fileEntries.end());
+
+		//each page takes bufMutex for itself and lets go of it while it is read, like a miss
+		std::function<std::uint32_t()> reader = [this, &fileEntries]() {
+			std::uint32_t read = 0;
+			FrameId cursor = 0;
+			for(std::size_t i = 0; i < fileEntries.size() && cursor < numBufs; i++) {
+				if(warmPage(fileEntries[i], cursor)) {
+					read++;
+				}
+			}
+			return read;
+		};
+		if(LatchingTraits<Latching>::threaded) {
+			readers.push_back(std::async(std::launch::async, reader));
+		}
+		else {
+			loaded += reader();
+		}
+	}
+	for(std::size_t r = 0; r < readers.size(); r++) {
+		loaded += readers[r].get();
+	}
+
+	return loaded;
+}
+
+/*
+ * The page goes the way of a miss, into a frame nobody uses instead of one the clock frees up,
+ * and is unpinned again right after. A page that cannot be read, because it was deleted since the
+ * list was written or does not match its checksum, is left for a real read to report.
+ */
+template<class Replacement, class Latching>
+bool BasicBufMgr<Replacement, Latching>::warmPage(const WarmEntry& entry, FrameId& cursor)
+{
+	std::lock_guard<Latching> lock(bufMutex);
+	FrameId frameNo;
+	if(findFrame(entry.file, entry.pageNo, frameNo)) {
+		return false;
+	}
+
+	while(cursor < numBufs && bufDescTable[cursor].valid) {
+		cursor++;
+	}
+	if(cursor == numBufs || !hasQuota(NULL)) {
+		cursor = numBufs;
+		return false;
+	}
+	frameNo = cursor;
+
+	hashTable->insert(entry.file, entry.pageNo, frameNo);
+	bufDescTable[frameNo].Set(entry.file, entry.pageNo);
+	policy.assign(frameNo);
+	chargeFrame(frameNo, NULL);
+	bufDescTable[frameNo].loading = true;
+	try {
+		bufPool[frameNo] = readFromDisk(entry.file, entry.pageNo, true);
+	} catch(BadgerDbException& e) {
+		hashTable->remove(entry.file, entry.pageNo);
+		clearFrame(frameNo);
+		pageLoaded.notify_all();
+		frameFreed.notify_all();
+		return false;
+	}
+	bufDescTable[frameNo].loading = false;
+	pageLoaded.notify_all();
+
+	//nobody asked for this page yet, so it should not stay pinned
+	unPinFrame(frameNo, false);
+	policy.setReferenced(frameNo, entry.refbit);
+	return true;
+}
+
+//the policies buffer.h declares as available, see BasicBufMgr
+template class BasicPageRef<BasicBufMgr<ClockReplacement, std::mutex> >;
+template class BasicPageHandle<BasicBufMgr<ClockReplacement, std::mutex> >;
+template class BasicBufMgr<ClockReplacement, std::mutex>;
+template class BasicPageRef<BasicBufMgr<ClockReplacement, NullMutex> >;
+template class BasicPageHandle<BasicBufMgr<ClockReplacement, NullMutex> >;
+template class BasicBufMgr<ClockReplacement, NullMutex>;
+
 }
@@ -0,0 +1,1933 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "file.h"
+#include "bufConfig.h"
+#include "bufHashTbl.h"
+#include "checksumFile.h"
+#include "compressedCache.h"
+#include "compressedPageStore.h"
+#include "doubleWriteBuffer.h"
+#include "flashCache.h"
+#include "frameBitmap.h"
+#include "mappedFile.h"
+#include "pageKey.h"
+#include "latencyHistogram.h"
+#include "pageLatch.h"
+
+namespace badgerdb {
+
+/**
+* forward declaration of BasicBufMgr class, and of BufMgr, the buffer manager built with the default policies
+*/
+template<class Replacement, class Latching> class BasicBufMgr;
+typedef BasicBufMgr<ClockReplacement, BufMutex> BufMgr;
+
+/**
+* @brief Frames of the buffer pool reserved for one client, such as a query, a thread or an operator.
+*
+* Created with BufMgr::reserveFrames(). Pages read or allocated under a grant are charged to it: a grant can have
+* at most as many frames pinned as it reserved, and clients without a grant can only pin the frames nobody reserved.
+* A frame is charged to whoever pinned it first and stays charged until its pin count drops back to zero.
+*/
+class BufGrant
+{
+  template<class, class> friend class BasicBufMgr;
+
+ private:
+  /**
+   * Number of frames reserved
+   */
+  std::uint32_t frames;
+
+  /**
+   * Number of frames currently pinned and charged to the grant
+   */
+  std::uint32_t pinned;
+
+  BufGrant(std::uint32_t framesIn)
+    : frames(framesIn), pinned(0)
+  {
+  }
+
+ public:
+  /**
+   * Number of frames reserved
+   */
+  std::uint32_t getFrames() const
+  {
+    return frames;
+  }
+
+  /**
+   * Number of frames currently pinned and charged to the grant
+   */
+  std::uint32_t getPinned() const
+  {
+    return pinned;
+  }
+};
+
+/**
+* @brief Ring of frames a large sequential scan reads its pages through, like PostgreSQL's BufferAccessStrategy.
+*
+* Created with BufMgr::getAccessStrategy(). Pages the scan reads in through the strategy go into the frames of the
+* ring in turn, and once the ring is full the scan recycles the frame of its own oldest page instead of taking one
+* from the clock. A scan over a large file so only ever displaces as many pages of the pool as the ring holds.
+* Pages that are already resident are pinned where they are and do not join the ring.
+*/
+class BufAccessStrategy
+{
+  template<class, class> friend class BasicBufMgr;
+
+ private:
+  /**
+   * Number of frames the ring holds
+   */
+  std::uint32_t ringSize;
+
+  /**
+   * Frames of the ring, filled up to ringSize as the scan reads pages in
+   */
+  std::vector<FrameId> frames;
+
+  /**
+   * Slot of the ring the next page goes into
+   */
+  std::uint32_t next;
+
+  BufAccessStrategy(std::uint32_t ringSizeIn)
+    : ringSize(ringSizeIn), next(0)
+  {
+    frames.reserve(ringSize);
+  }
+
+ public:
+  /**
+   * Number of frames the ring holds
+   */
+  std::uint32_t getRingSize() const
+  {
+    return ringSize;
+  }
+};
+
+/**
+* @brief Reference to a page that turns into a direct link to its frame while the page is resident.
+*
+* A PageRef names a page by file and page number. The first time it is read through BufMgr::readPage(PageRef&, ...)
+* it is swizzled: it remembers the frame holding the page, and later reads through it pin that frame directly
+* without a hash table lookup. When the frame is evicted or flushed the buffer manager unswizzles the reference
+* again. A frame is linked to at most one PageRef; other references to the same page keep using the hash table.
+*
+* References can be moved but not copied. A reference that is still swizzled when it is destroyed unlinks itself
+* from its buffer manager, which must therefore still exist.
+*
+* Manager is the buffer manager the reference is read through, PageRef is the reference for BufMgr.
+*/
+template<class Manager>
+class BasicPageRef
+{
+  friend Manager;
+
+ private:
+  /**
+   * File the page belongs to
+   */
+  File* file;
+
+  /**
+   * Page number in the file
+   */
+  PageId pageNo;
+
+  /**
+   * Buffer manager holding the page while swizzled, NULL otherwise
+   */
+  Manager* bufMgr;
+
+  /**
+   * Frame holding the page while swizzled
+   */
+  FrameId frameNo;
+
+ public:
+  /**
+   * Constructs an unswizzled reference to a page
+   *
+   * @param fileIn   	File the page belongs to
+   * @param pageNoIn   	Page number in the file
+   */
+  BasicPageRef(File* fileIn, PageId pageNoIn)
+    : file(fileIn), pageNo(pageNoIn), bufMgr(NULL), frameNo(0)
+  {
+  }
+
+  BasicPageRef(const BasicPageRef&) = delete;
+  BasicPageRef& operator=(const BasicPageRef&) = delete;
+
+  BasicPageRef(BasicPageRef&& other);
+  BasicPageRef& operator=(BasicPageRef&& other);
+
+  /**
+   * Unlinks the reference from its frame if it is swizzled
+   */
+  ~BasicPageRef();
+
+  /**
+   * True while the reference points straight at a frame
+   */
+  bool isSwizzled() const
+  {
+    return bufMgr != NULL;
+  }
+
+  /**
+   * File the page belongs to
+   */
+  File* getFile() const
+  {
+    return file;
+  }
+
+  /**
+   * Page number in the file
+   */
+  PageId getPageNo() const
+  {
+    return pageNo;
+  }
+};
+
+/**
+* Reference to a page read through BufMgr
+*/
+typedef BasicPageRef<BufMgr> PageRef;
+
+/**
+* @brief Class for maintaining information about buffer pool frames
+*
+* Ref is the page reference of the buffer manager the frame belongs to.
+*/
+template<class Ref>
+class BufDesc {
+
+	template<class, class> friend class BasicBufMgr;
+
+ private:
+  /**
+   * Pointer to file to which corresponding frame is assigned
+   */
+  File* file;
+
+  /**
+   * Page within file to which corresponding frame is assigned
+   */
+  PageId pageNo;
+
+  /**
+   * Frame number of the frame, in the buffer pool, being used
+   */
+  FrameId frameNo;
+
+  /**
+   * Number of times this page has been pinned
+   */
+  int pinCnt;
+
+  /**
+   * True if page is dirty;  false otherwise
+   */
+  bool dirty;
+
+  /**
+   * True if page is valid
+   */
+  bool valid;
+
+  /**
+   * Number of hits on this frame since it was assigned to its page. Folded into the per-file
+   * statistics when the frame is cleared, so the hit path never touches a per-file table.
+   */
+  std::uint32_t hitCnt;
+
+  /**
+   * Latch on the contents of the frame. Only taken by threads holding a pin, so a latched frame is never evicted.
+   */
+  PageLatch latch;
+
+  /**
+   * Reference swizzled to this frame, NULL if there is none
+   */
+  Ref* swizzledRef;
+
+  /**
+   * Grant the frame is charged to while pinned, NULL if it is charged to the unreserved part of the pool
+   */
+  BufGrant* chargedTo;
+
+  /**
+   * Access strategy whose ring the frame belongs to, NULL if it is left to the clock
+   */
+  BufAccessStrategy* ring;
+
+  /**
+   * True while the frame waits for the background writer
+   */
+  bool writeQueued;
+
+  /**
+   * Bumped whenever the page in the frame is dirtied, written back or dropped. The background writer writes a
+   * copy of the page with bufMutex released, and only marks the frame clean if this did not move meanwhile.
+   * Clear() leaves it alone, so a frame that was given to another page never matches an old count.
+   */
+  std::uint32_t changeCount;
+
+  /**
+   * True while a miss reads the page into the frame with bufMutex released. The frame is pinned and in the
+   * hash table meanwhile, so nobody takes it, but its contents are not there yet.
+   */
+  bool loading;
+
+  /**
+   * Initialize buffer frame for a new user
+   */
+  void Clear()
+  {
+    pinCnt = 0;
+		file = NULL;
+		pageNo = Page::INVALID_NUMBER;
+    dirty = false;
+    valid = false;
+    hitCnt = 0;
+    swizzledRef = NULL;
+    chargedTo = NULL;
+    ring = NULL;
+    writeQueued = false;
+    loading = false;
+  };
+
+  /**
+   * Set values of member variables corresponding to assignment of frame to a page in the file. Called when a frame 
+   * in buffer pool is allocated to any page in the file through readPage() or allocPage()
+   *
+   * @param filePtr	File object
+   * @param pageNum	Page number in the file
+   */
+  void Set(File* filePtr, PageId pageNum)
+  { 
+		file = filePtr;
+    pageNo = pageNum;
+    pinCnt = 1;
+    dirty = false;
+    valid = true;
+  }
+
+  /**
+   * @param refbit   	Refbit of the frame, which is kept by the buffer manager's replacement policy
+   */
+  void Print(bool refbit)
+  {
+		if(file)
+		{
+			std::cout << "file:" << file->filename() << " ";
+			std::cout << "pageNo:" << pageNo << " ";
+		}
+		else
+			std::cout << "file:NULL ";
+
+		std::cout << "valid:" << valid << " ";
+		std::cout << "pinCnt:" << pinCnt << " ";
+		std::cout << "dirty:" << dirty << " ";
+		std::cout << "refbit:" << refbit << "\n";
+  }
+
+  /**
+   * Constructor of BufDesc class 
+   */
+  BufDesc()
+    : changeCount(0)
+  {
+		Clear();
+  }
+};
+
+
+/**
+* @brief Hit and miss counts of the pages of one file
+*/
+struct BufFileStats
+{
+  /**
+   * Number of accesses to pages of the file that found the page in the buffer pool
+   */
+  std::uint64_t hits;
+
+  /**
+   * Number of accesses to pages of the file that had to read the page from disk
+   */
+  std::uint64_t misses;
+
+  /**
+   * Fraction of accesses that were hits, 0 if the file was never accessed
+   */
+  double hitRatio() const
+  {
+    return hits + misses == 0 ? 0.0 : (double) hits / (hits + misses);
+  }
+
+  BufFileStats()
+    : hits(0), misses(0)
+  {
+  }
+};
+
+
+/**
+* @brief Class to maintain statistics of buffer usage 
+*/
+struct BufStats
+{
+  /**
+   * Total number of accesses to buffer pool
+   */
+  int accesses;
+
+  /**
+   * Number of pages read from disk (including allocs)
+   */
+  int diskreads;
+
+  /**
+   * Number of pages written back to disk
+   */
+  int diskwrites;
+
+  /**
+   * Number of buckets in the clock sweep length histogram
+   */
+  static const int SWEEP_BUCKETS = 32;
+
+  /**
+   * Number of accesses that found the page in the buffer pool
+   */
+  std::uint64_t hits;
+
+  /**
+   * Number of accesses that had to read the page from disk
+   */
+  std::uint64_t misses;
+
+  /**
+   * Number of valid pages evicted to make room for another page
+   */
+  std::uint64_t evictions;
+
+  /**
+   * Number of evicted pages that had to be written back first
+   */
+  std::uint64_t dirtyEvictions;
+
+  /**
+   * Histogram of the number of frames the clock hand examined per frame allocation.
+   * Bucket i counts allocations that examined between 2^i and 2^(i+1) - 1 frames.
+   */
+  std::uint64_t sweepLengths[SWEEP_BUCKETS];
+
+  /**
+   * Number of flushFile() calls
+   */
+  std::uint64_t flushes;
+
+  /**
+   * Total time spent in flushFile(), in nanoseconds
+   */
+  std::uint64_t flushNanos;
+
+  /**
+   * Longest single flushFile() call, in nanoseconds
+   */
+  std::uint64_t maxFlushNanos;
+
+  /**
+   * Number of frame allocations that had to wait because every frame was pinned
+   */
+  std::uint64_t pinWaits;
+
+  /**
+   * Number of those waits that timed out
+   */
+  std::uint64_t pinWaitTimeouts;
+
+  /**
+   * Total time spent waiting for a frame, in nanoseconds
+   */
+  std::uint64_t pinWaitNanos;
+
+  /**
+   * Number of frames a scan recycled from its own ring instead of taking one from the clock
+   */
+  std::uint64_t ringReuses;
+
+  /**
+   * Number of page checksums computed on write-back
+   */
+  std::uint64_t checksumsComputed;
+
+  /**
+   * Number of pages read from disk whose checksum was verified
+   */
+  std::uint64_t checksumsVerified;
+
+  /**
+   * Number of pages read from disk that did not match their checksum
+   */
+  std::uint64_t checksumFailures;
+
+  /**
+   * Total time spent computing and verifying checksums, in nanoseconds
+   */
+  std::uint64_t checksumNanos;
+
+  /**
+   * Number of batches written through the double-write area
+   */
+  std::uint64_t doubleWriteFlushes;
+
+  /**
+   * Number of pages written through the double-write area
+   */
+  std::uint64_t doubleWritePages;
+
+  /**
+   * Number of misses served from the compressed second tier instead of the file
+   */
+  std::uint64_t secondTierHits;
+
+  /**
+   * Number of evicted pages kept in the compressed second tier
+   */
+  std::uint64_t secondTierStores;
+
+  /**
+   * Number of misses served from the flash cache instead of the file
+   */
+  std::uint64_t flashHits;
+
+  /**
+   * Number of evicted pages admitted to the flash cache
+   */
+  std::uint64_t flashAdmits;
+
+  /**
+   * Number of dirty frames the clock handed to the background writer to look for a clean one instead
+   */
+  std::uint64_t cleanVictimSkips;
+
+  /**
+   * Number of dirty frames written back by the background writer
+   */
+  std::uint64_t backgroundWrites;
+
+  /**
+   * Hits and misses per file, keyed by file name
+   */
+  std::map<std::string, BufFileStats> files;
+
+  /**
+   * Clear all values 
+   */
+  void clear()
+  {
+    accesses = diskreads = diskwrites = 0;
+    hits = misses = evictions = dirtyEvictions = 0;
+    flushes = flushNanos = maxFlushNanos = 0;
+    pinWaits = pinWaitTimeouts = pinWaitNanos = 0;
+    ringReuses = 0;
+    checksumsComputed = checksumsVerified = checksumFailures = checksumNanos = 0;
+    doubleWriteFlushes = doubleWritePages = 0;
+    secondTierHits = secondTierStores = 0;
+    flashHits = flashAdmits = 0;
+    cleanVictimSkips = backgroundWrites = 0;
+    for(int i = 0; i < SWEEP_BUCKETS; i++)
+      sweepLengths[i] = 0;
+    files.clear();
+  }
+      
+  /**
+   * Constructor of BufStats class 
+   */
+  BufStats()
+  {
+    clear();
+  }
+};
+
+
+/**
+* @brief Latency histograms of the buffer manager and of the disk I/O it issues
+*/
+struct BufLatency
+{
+  /**
+   * readPage() calls that found the page in the buffer pool
+   */
+  LatencyHistogram readHit;
+
+  /**
+   * readPage() calls that had to read the page from disk, including the frame allocation and the read
+   */
+  LatencyHistogram readMiss;
+
+  /**
+   * allocBuf() calls, including the write-back of a dirty victim
+   */
+  LatencyHistogram allocBuf;
+
+  /**
+   * File::readPage() calls made by the buffer manager
+   */
+  LatencyHistogram fileRead;
+
+  /**
+   * File::writePage() calls made by the buffer manager
+   */
+  LatencyHistogram fileWrite;
+
+  /**
+   * Print the percentiles of every histogram
+   */
+  void print(std::ostream& out) const
+  {
+    readHit.print(out, "readPage hit");
+    readMiss.print(out, "readPage miss");
+    allocBuf.print(out, "allocBuf");
+    fileRead.print(out, "File::readPage");
+    fileWrite.print(out, "File::writePage");
+  }
+
+  /**
+   * Clear all histograms
+   */
+  void clear()
+  {
+    readHit.clear();
+    readMiss.clear();
+    allocBuf.clear();
+    fileRead.clear();
+    fileWrite.clear();
+  }
+};
+
+
+/**
+* @brief Pin on a page in the buffer pool that is released when the handle goes out of scope.
+*
+* Returned by the BufMgr::readPage() and BufMgr::allocPage() overloads that do not take a page pointer. The handle
+* remembers the frame holding the page, so unpinning goes straight to the frame without a hash table lookup.
+* Handles can be moved but not copied, and must not outlive the buffer manager they came from.
+*
+* Releasing a handle never throws. If its pin was dropped some other way, say by unPinPage() on the same page,
+* and the frame has since been given to another page, the release leaves that page alone.
+*
+* Manager is the buffer manager the page is pinned in, PageHandle is the handle for BufMgr.
+*/
+template<class Manager>
+class BasicPageHandle
+{
+  friend Manager;
+
+ private:
+  /**
+   * Buffer manager the page is pinned in, NULL if the handle holds no pin
+   */
+  Manager* bufMgr;
+
+  /**
+   * Frame holding the page
+   */
+  FrameId frameNo;
+
+  /**
+   * File of the pinned page, to tell whether the frame still holds it when the handle is released
+   */
+  const File* file;
+
+  /**
+   * Page number of the pinned page in its file
+   */
+  PageId pageNo;
+
+  /**
+   * The pinned page
+   */
+  Page* page;
+
+  /**
+   * True if the page is unpinned as dirty
+   */
+  bool dirty;
+
+  /**
+   * Mode the page contents are latched in
+   */
+  LatchMode latchMode;
+
+  BasicPageHandle(Manager* bufMgrIn, FrameId frameNoIn, const File* fileIn, PageId pageNoIn, Page* pageIn, LatchMode latchModeIn)
+    : bufMgr(bufMgrIn), frameNo(frameNoIn), file(fileIn), pageNo(pageNoIn), page(pageIn), dirty(false), latchMode(latchModeIn)
+  {
+  }
+
+ public:
+  /**
+   * Constructs a handle that holds no pin
+   */
+  BasicPageHandle()
+    : bufMgr(NULL), frameNo(0), file(NULL), pageNo(0), page(NULL), dirty(false), latchMode(LATCH_NONE)
+  {
+  }
+
+  BasicPageHandle(const BasicPageHandle&) = delete;
+  BasicPageHandle& operator=(const BasicPageHandle&) = delete;
+
+  BasicPageHandle(BasicPageHandle&& other)
+    : bufMgr(other.bufMgr), frameNo(other.frameNo), file(other.file), pageNo(other.pageNo), page(other.page),
+      dirty(other.dirty), latchMode(other.latchMode)
+  {
+    other.bufMgr = NULL;
+    other.page = NULL;
+  }
+
+  BasicPageHandle& operator=(BasicPageHandle&& other)
+  {
+    if(this != &other)
+    {
+      release();
+      bufMgr = other.bufMgr;
+      frameNo = other.frameNo;
+      file = other.file;
+      pageNo = other.pageNo;
+      page = other.page;
+      dirty = other.dirty;
+      latchMode = other.latchMode;
+      other.bufMgr = NULL;
+      other.page = NULL;
+    }
+    return *this;
+  }
+
+  /**
+   * Releases the latch and unpins the page if the handle still holds a pin
+   */
+  ~BasicPageHandle()
+  {
+    release();
+  }
+
+  /**
+   * Release the latch and unpin the page now instead of when the handle is destroyed.
+   * Does nothing if the handle holds no pin.
+   */
+  void release() noexcept;
+
+  /**
+   * Turn a shared latch into an exclusive one. Only succeeds if no other thread holds the latch.
+   *
+   * @return  True if the handle now holds the latch exclusively
+   */
+  bool tryUpgrade();
+
+  /**
+   * Turn an exclusive latch into a shared one
+   */
+  void downgrade();
+
+  /**
+   * Mode the page contents are latched in
+   */
+  LatchMode mode() const
+  {
+    return latchMode;
+  }
+
+  /**
+   * Have the page marked dirty when it is unpinned
+   */
+  void markDirty()
+  {
+    dirty = true;
+  }
+
+  /**
+   * True if the handle holds a pin
+   */
+  explicit operator bool() const
+  {
+    return bufMgr != NULL;
+  }
+
+  /**
+   * The pinned page, NULL if the handle holds no pin
+   */
+  Page* get() const
+  {
+    return page;
+  }
+
+  Page* operator->() const
+  {
+    return page;
+  }
+
+  Page& operator*() const
+  {
+    return *page;
+  }
+};
+
+
+/**
+* Pin on a page of BufMgr
+*/
+typedef BasicPageHandle<BufMgr> PageHandle;
+
+
+/**
+* @brief The central class which manages the buffer pool including frame allocation and deallocation to pages in the file 
+*
+* The policies a deployment fixes when it is built are template parameters, so the compiler can inline them
+* into readPage() and allocBuf() instead of going through a runtime choice:
+* - Replacement keeps the valid, pinned and referenced state of the frames and picks the frames that are evicted:
+*   victim() for a single frame and victimRun() for a run. It has the members of FrameBitmap, the clock, which
+*   ClockReplacement names. The buffer manager only evicts the pages in the frames it is given.
+* - Latching is the mutex type of the pool and its files: BufMutex for a pool used by several threads, NullMutex
+*   for a pool only ever used by one, see bufConfig.h.
+*
+* BufMgr is the buffer manager with the default policies. The members are defined in buffer.cpp, which
+* instantiates the clock with both mutex types; another combination needs its own line there.
+*/
+template<class Replacement, class Latching>
+class BasicBufMgr 
+{
+ public:
+  /**
+   * Reference to a page read through this buffer manager
+   */
+  typedef BasicPageRef<BasicBufMgr> PageRef;
+
+  /**
+   * Pin on a page of this buffer manager
+   */
+  typedef BasicPageHandle<BasicBufMgr> PageHandle;
+
+ private:
+  /**
+   * Frame descriptor of this buffer manager
+   */
+  typedef badgerdb::BufDesc<PageRef> BufDesc;
+
+  /**
+   * Number of frames in the buffer pool
+   */
+  std::uint32_t numBufs;
+
+  /**
+   * Hash table mapping (File, page) to frame
+   */
+  BufHashTbl *hashTable;
+
+  /**
+   * Array of BufDesc objects to hold information corresponding to every frame allocation from 'bufPool' (the buffer pool)
+   */
+  BufDesc *bufDescTable;
+
+  /**
+   * Valid, pinned and referenced state of every frame, kept by the replacement policy
+   */
+  Replacement policy;
+
+  /**
+   * Maintains Buffer pool usage statistics 
+   */
+  BufStats bufStats;
+
+  /**
+   * Protects the frame descriptors, the hash table and the statistics. Page contents are protected
+   * by the latches in the frame descriptors, which are never waited for while holding this mutex.
+   * A miss reads its page with the mutex released, see BufDesc::loading.
+   */
+  Latching bufMutex;
+
+  /**
+   * Number of mutexes the files are spread over
+   */
+  static const std::uint32_t FILE_MUTEXES = 16;
+
+  /**
+   * Serialize the I/O on the files and their compressed stores, which cannot take two calls at once. A file
+   * mutex is only ever taken after bufMutex or without it, never the other way round.
+   */
+  Latching fileMutexes[FILE_MUTEXES];
+
+  /**
+   * Latency histograms, only recorded while latencyTracking is set
+   */
+  BufLatency bufLatency;
+
+  /**
+   * True if calls are being timed into bufLatency. Only read and written with bufMutex held.
+   */
+  bool latencyTracking;
+
+  /**
+   * File the resident page list is written to when the buffer manager is destroyed. Empty if disabled.
+   */
+  std::string residentListPath;
+
+  /**
+   * How long allocBuf() waits for a frame to be unpinned when all are pinned. Zero means it does not wait.
+   */
+  std::chrono::milliseconds frameWaitTimeout;
+
+  /**
+   * Signalled whenever a frame becomes available for eviction while someone waits for one
+   */
+  std::condition_variable_any frameFreed;
+
+  /**
+   * Signalled whenever a miss is done reading its page, or gave up on it
+   */
+  std::condition_variable_any pageLoaded;
+
+  /**
+   * Tickets of the threads waiting for a frame, in arrival order
+   */
+  std::deque<std::uint64_t> frameWaiters;
+
+  /**
+   * Ticket handed to the next thread that has to wait for a frame
+   */
+  std::uint64_t nextWaitTicket;
+
+  /**
+   * Total number of frames reserved by outstanding grants
+   */
+  std::uint32_t reservedFrames;
+
+  /**
+   * Number of pinned frames charged to the unreserved part of the pool
+   */
+  std::uint32_t unreservedPinned;
+
+  /**
+   * Number of frames that can never be reserved, kept for clients without a grant
+   */
+  std::uint32_t unreservedHeadroom;
+
+  /**
+   * Disposed pages whose frames are gone but which are not yet deleted from their files
+   */
+  std::vector<std::pair<File*, PageId> > disposeQueue;
+
+  /**
+   * Number of disposed pages collected before they are deleted from their files together, 0 to delete each one right away
+   */
+  std::uint32_t disposeBatch;
+
+  /**
+   * Background deletion of the last batch of disposed pages, if one was started. It puts the pages it could not
+   * delete back into disposeQueue, and its error is rethrown by the next disposePage(), disposeFile() or
+   * drainDisposeQueue().
+   */
+  std::future<void> disposeDrain;
+
+  /**
+   * Number of frames the clock passes looking for a clean frame when the one it would take is dirty, 0 to take it
+   */
+  std::uint32_t cleanVictimSearch;
+
+  /**
+   * Number of dirty frames that may wait for the background writer
+   */
+  std::uint32_t writeQueueLimit;
+
+  /**
+   * Dirty frames waiting for the background writer, with the page each held when it was queued
+   */
+  std::deque<std::pair<FrameId, PageKey> > writeQueue;
+
+  /**
+   * True while the background writer works through writeQueue
+   */
+  bool writerRunning;
+
+  /**
+   * The background writer, if one was started
+   */
+  std::future<void> writerDrain;
+
+  /**
+   * True if pages are checksummed on write-back and verified on read
+   */
+  bool checksumsEnabled;
+
+  /**
+   * Checksum files of the files this buffer manager read or wrote pages of, NULL for a file that has none yet.
+   * A file's entry is closed when the file is flushed or disposed, as its File object may be reused after that.
+   */
+  std::map<const File*, ChecksumFile*> checksumFiles;
+
+  /**
+   * Batch of written back pages on their way through the double-write area, NULL if pages are written in place directly
+   */
+  DoubleWriteBuffer* doubleWrite;
+
+  /**
+   * True while a double-write batch is written, with bufMutex let go of
+   */
+  bool doubleWriteFlushing;
+
+  /**
+   * Signalled whenever a double-write batch is done being written, or gave up
+   */
+  std::condition_variable_any doubleWriteDone;
+
+  /**
+   * True while a background task writes full double-write batches
+   */
+  bool doubleWriteRunning;
+
+  /**
+   * The background task writing full double-write batches, if one was started
+   */
+  std::future<void> doubleWriteDrain;
+
+  /**
+   * Compressed store each file's pages are written to instead of the file itself, for files that have one
+   */
+  std::map<const File*, CompressedPageStore*> compressedStores;
+
+  /**
+   * Compressed in-memory tier evicted pages go to, NULL if there is none
+   */
+  CompressedCache* secondTier;
+
+  /**
+   * Cache on a fast local device evicted pages are admitted to, NULL if there is none
+   */
+  FlashCache* flashCache;
+
+  /**
+   * Clear the frame for a new user, first folding its hit count into the per-file statistics
+   *
+   * @param frameNo   	Frame to clear
+   */
+  void clearFrame(FrameId frameNo);
+
+  /**
+   * Read a page from its file, counting and timing the read
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @param releaseMutex	True to let go of bufMutex while the file is read. The caller must have pinned the
+   *                    	frame the page goes to, and marked it loading.
+   * @return  The page read from the file
+   */
+  Page readFromDisk(File* file, const PageId pageNo, bool releaseMutex = false);
+
+  /**
+   * Write the page held in a frame back to its file, counting and timing the write, and mark the frame clean
+   *
+   * @param frameNo   	Frame holding the page
+   */
+  void writeToDisk(FrameId frameNo);
+
+  /**
+   * Mark a frame clean after its page was written back, and record the checksum of what was written
+   *
+   * @param frameNo   	Frame holding the page
+   * @param image   	The page as it was written, which a pinned frame may have moved on from
+   */
+  void markWritten(FrameId frameNo, const Page& image);
+
+  /**
+   * Check a page just read from disk against the checksum it was written with, if there is one
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @param page   	The page as it was read
+   * @param expected	The checksum the page was written with is returned via this reference if it does not match
+   * @return  False if the page does not match its checksum
+   */
+  bool verifyChecksum(File* file, const PageId pageNo, const Page& page, std::uint32_t& expected);
+
+  /**
+   * Forget the checksum of a page that is deleted from its file, or written without one
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   */
+  void forgetChecksum(File* file, const PageId pageNo);
+
+  /**
+   * Checksum file of a file, opened the first time it is needed
+   *
+   * @param file   	File object
+   * @param create   	True to create the checksum file if the file has none
+   * @return  The checksum file, NULL if there is none and create is false
+   */
+  ChecksumFile* checksumsFor(const File* file, bool create);
+
+  /**
+   * Close the checksum file of a file, if it is open
+   *
+   * @param file   	File object
+   */
+  void closeChecksums(const File* file);
+
+  /**
+   * Collect the background deletion of disposed pages if it is done. Called with bufMutex held.
+   *
+   * @throws BadgerDbException The error the background deletion ran into, if any
+   */
+  void collectDisposeDrain();
+
+  /**
+   * Write the batch of the double-write area out, if there is one, after the batch being written already.
+   * Called with bufMutex held, which is let go of while the batch is written and synced; each page is written in
+   * place with its file's mutex held.
+   *
+   * @throws DoubleWriteException If the area or a file cannot be written or synced, the pages stay in the batch then
+   */
+  void flushDoubleWrite();
+
+  /**
+   * Compressed store of the file, NULL if its pages go to the file itself
+   */
+  CompressedPageStore* storeFor(const File* file) const
+  {
+    if(compressedStores.empty())
+      return NULL;
+    std::map<const File*, CompressedPageStore*>::const_iterator it = compressedStores.find(file);
+    return it == compressedStores.end() ? NULL : it->second;
+  }
+
+  /**
+   * Mutex serializing the I/O on a file
+   */
+  Latching& fileMutex(const File* file)
+  {
+    return fileMutexes[(reinterpret_cast<std::uintptr_t>(file) >> 4) % FILE_MUTEXES];
+  }
+
+  /**
+   * Look a page up in the hash table, waiting for it if a miss is still reading it in
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @param frameNo	Frame holding the page, returned via this variable
+   * @return  False if the page is not in the buffer pool
+   */
+  bool findFrame(const File* file, const PageId pageNo, FrameId& frameNo);
+
+  /**
+   * Have the replacement policy pick a frame that can be used and evict the page in it. A dirty page is passed
+   * over for a clean one and queued for the background writer, see setCleanVictimSearch().
+   *
+   * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+   * @throws BufferExceededException If no such buffer is found which can be allocated
+   */
+  void takeVictim(FrameId & frame);
+
+  /**
+   * Take a turn at the frames: check the quota of the grant and, if a frame is wanted, sweep the clock for one.
+   * If that fails, or others are already waiting, waits in line for up to frameWaitTimeout for an unpin.
+   * Called with bufMutex held, which is released while waiting.
+   *
+   * @param grant   	Grant the frame is going to be charged to, NULL for none
+   * @param frame   	Frame ID of the allocated frame is returned here, NULL to wait for the quota only
+   * @throws BufferExceededException If the turn does not come before the timeout
+   */
+  void waitInLine(BufGrant* grant, FrameId* frame);
+
+  /**
+   * Allocate a free frame. If every frame is pinned, or the grant has none left, waits in line for up to
+   * frameWaitTimeout for one to be unpinned. Called with bufMutex held, which is released while waiting.
+   * The quota of the grant is checked before the clock evicts anything, and again after every wait.
+   *
+   * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+   * @param grant   	Grant the frame is going to be charged to, NULL for none
+   * @throws BufferExceededException If no such buffer is found which can be allocated, or the frame
+   *         cannot be charged
+   */
+  void allocBuf(FrameId & frame, BufGrant* grant = NULL);
+
+  /**
+   * Evict the valid, unpinned page held in a frame: write it back if it is dirty, hand it to the second tier
+   * and the flash cache, and clear the frame
+   *
+   * @param frameNo   	Frame holding the page
+   */
+  void evictFrame(FrameId frameNo);
+
+  /**
+   * Allocate a run of frames that starts at a multiple of its size, evicting whatever they hold. The run is
+   * picked by the replacement policy.
+   *
+   * @param runFrames   	Number of frames in the run, a power of two
+   * @param head   	First frame of the run is returned via this variable
+   * @throws BufferExceededException If every run of that size has a pinned frame
+   */
+  void allocRun(std::uint32_t runFrames, FrameId & head);
+
+  /**
+   * Allocate a frame for a page read through an access strategy. Recycles the frame in the next slot of the
+   * ring if the scan's page there is no longer pinned and nobody else used it, and takes one from allocBuf()
+   * otherwise. Like allocBuf(), checks the quota before anything is evicted, and waits for it if it has to.
+   *
+   * @param strategy   	Access strategy of the scan
+   * @param frame   	Frame reference, frame ID of allocated frame returned via this variable
+   * @param grant   	Grant the frame is going to be charged to, NULL for none
+   * @throws BufferExceededException If no such buffer is found which can be allocated, or the frame
+   *         cannot be charged
+   */
+  void allocRingBuf(BufAccessStrategy* strategy, FrameId & frame, BufGrant* grant = NULL);
+
+  /**
+   * Whether one more frame can be pinned under the grant, or under no grant
+   *
+   * @param grant   	Grant to charge, NULL for the unreserved part of the pool
+   * @return  False if the grant, or the unreserved part of the pool, has no frame left
+   */
+  bool hasQuota(const BufGrant* grant) const
+  {
+    if(grant != NULL)
+      return grant->pinned < grant->frames;
+    return unreservedPinned < numBufs - reservedFrames;
+  }
+
+  /**
+   * Check that one more frame can be pinned under the grant, or under no grant
+   *
+   * @param grant   	Grant to charge, NULL for the unreserved part of the pool
+   * @throws BufferExceededException If the grant, or the unreserved part of the pool, has no frame left
+   */
+  void checkQuota(BufGrant* grant);
+
+  /**
+   * Charge a frame that just went from unpinned to pinned
+   *
+   * @param frameNo   	Frame being pinned
+   * @param grant   	Grant to charge, NULL for the unreserved part of the pool
+   */
+  void chargeFrame(FrameId frameNo, BufGrant* grant);
+
+  /**
+   * Give the charge of a frame that is no longer pinned back
+   *
+   * @param frameNo   	Frame being unpinned
+   */
+  void unchargeFrame(FrameId frameNo);
+
+  /**
+   * Pin the page, reading it into a frame first if it is not in the buffer pool
+   *
+   * @param file   	File object
+   * @param pageNo  Page number in the file
+   * @param grant   	Grant the frame is charged to if this pins it first, NULL for none
+   * @param strategy   	Access strategy whose ring a page read in goes into, NULL for the clock
+   * @return  Frame holding the page
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned,
+   *         or the frame cannot be charged
+   */
+  FrameId pinPage(File* file, const PageId pageNo, BufGrant* grant = NULL, BufAccessStrategy* strategy = NULL);
+
+  /**
+   * Pin the page named by a reference, going straight to its frame if the reference is swizzled
+   * and swizzling it otherwise
+   *
+   * @param ref   	Reference to the page
+   * @return  Frame holding the page
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   */
+  FrameId pinRef(PageRef& ref);
+
+  /**
+   * Allocate a new page in the file and pin it in a frame
+   *
+   * @param file   	File object
+   * @param pageNo  The number assigned to the page in the file is returned via this reference
+   * @param grant   	Grant the frame is charged to, NULL for none
+   * @return  Frame holding the page
+   * @throws BufferExceededException If every frame is pinned or the frame cannot be charged
+   */
+  FrameId pinNewPage(File* file, PageId &pageNo, BufGrant* grant = NULL);
+
+  /**
+   * Unpin the page held in a frame. Called with bufMutex held.
+   *
+   * @param frameNo   	Frame holding the page
+   * @param dirty		True if the page needs to be marked dirty
+   * @throws  PageNotPinnedException If the page is not pinned
+   */
+  void unPinFrame(FrameId frameNo, const bool dirty);
+
+  /**
+   * Release the latch a page handle holds and unpin its frame. Does nothing if the frame no longer
+   * holds the handle's page pinned.
+   *
+   * @param handle   	Handle holding the pin
+   */
+  void releaseHandle(const PageHandle& handle) noexcept;
+
+  /**
+   * Unlink the reference from the frame it is swizzled to, if any
+   *
+   * @param ref   	Page reference
+   */
+  void unswizzle(PageRef& ref);
+
+  /**
+   * Hand the frame link of one reference over to another, used when references are moved
+   *
+   * @param from   	Reference being moved from
+   * @param to   	Reference being moved to, not swizzled
+   */
+  void moveSwizzle(PageRef& from, PageRef& to);
+
+  /**
+   * Delete a batch of disposed pages from their files, grouped by file and in page number order.
+   * Called with bufMutex held.
+   *
+   * @param batch   	Pages to delete
+   */
+  void deletePages(std::vector<std::pair<File*, PageId> >& batch);
+
+  /**
+   * Hand a dirty frame to the background writer, starting the writer if it is not running. Called with bufMutex held.
+   *
+   * @param frameNo   	Frame of the dirty page
+   */
+  void queueWrite(FrameId frameNo);
+
+  /**
+   * Write back the first frame waiting for the writer, if it still holds the same page, is dirty and is not
+   * pinned. Called with bufMutex held, which is let go of while a copy of the page is written, with the
+   * file's mutex held instead; pages going through the double-write area are written with bufMutex held.
+   */
+  void writeQueued();
+
+  /**
+   * Take the pages of a file off the writer's queue and wait for a write of the file the writer is in the
+   * middle of. Called with bufMutex held, which keeps the writer from starting another one.
+   *
+   * @param file   	File whose writes are dropped
+   */
+  void dropQueuedWrites(const File* file);
+
+  /**
+   * Entry of a resident page list read by warmUp()
+   */
+  struct WarmEntry
+  {
+    File* file;
+    PageId pageNo;
+    bool refbit;
+  };
+
+  /**
+   * Read a page of a resident page list into a free frame and leave it unpinned. Takes bufMutex, and lets go of it
+   * while the page is read.
+   *
+   * @param entry   	The page and the refbit it had
+   * @param cursor   	First frame that may be free, moved on past the frame used. Set to numBufs once no free
+   *                 	frame is left.
+   * @return  True if the page was loaded, false if it was resident already, could not be read or did not fit
+   */
+  bool warmPage(const WarmEntry& entry, FrameId& cursor);
+
+  friend PageRef;
+
+  /**
+   * Frame holding the given page of the buffer pool
+   */
+  FrameId frameOf(const Page* page) const
+  {
+    return (FrameId) (page - bufPool);
+  }
+
+  friend PageHandle;
+
+ public:
+  /**
+   * Actual buffer pool from which frames are allocated
+   */
+  Page* bufPool;
+
+  /**
+   * Constructor of BufMgr class
+   */
+  BasicBufMgr(std::uint32_t bufs);
+
+  /**
+   * Destructor of BufMgr class
+   */
+  ~BasicBufMgr();
+
+  /**
+   * Reads the given page from the file into a frame and returns the pointer to page.
+   * If the requested page is already present in the buffer pool pointer to that frame is returned
+   * otherwise a new frame is allocated from the buffer pool for reading the page.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   * @throws PageChecksumException If the page had to be read from disk and does not match the checksum it was written with
+   */
+  void readPage(File* file, const PageId PageNo, Page*& page);
+
+  /**
+   * Reads the given page like readPage(File*, const PageId, Page*&), but returns a handle that unpins the page
+   * when it goes out of scope.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @return  Handle holding the pin on the page
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   */
+  PageHandle readPage(File* file, const PageId PageNo);
+
+  /**
+   * Reads the given page like readPage(File*, const PageId, Page*&) and latches its contents in the given mode.
+   * The latch is taken after the page is pinned, so threads can hold the latch of a parent page while they
+   * read and latch a child. The page has to be unpinned with the same latch mode.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @param mode  	Mode to latch the page contents in
+   * @param grant  	Frame reservation to charge the page to, NULL for the unreserved part of the pool
+   * @param strategy  	Access strategy of a scan, NULL to read the page in like any other
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned,
+   *         or the grant has no frame left
+   */
+  void readPage(File* file, const PageId PageNo, Page*& page, LatchMode mode, BufGrant* grant = NULL,
+                BufAccessStrategy* strategy = NULL);
+
+  /**
+   * Reads and latches the given page, returning a handle that releases the latch and the pin when it goes out of scope.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param mode  	Mode to latch the page contents in
+   * @param grant  	Frame reservation to charge the page to, NULL for the unreserved part of the pool
+   * @param strategy  	Access strategy of a scan, NULL to read the page in like any other
+   * @return  Handle holding the pin and the latch on the page
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned,
+   *         or the grant has no frame left
+   */
+  PageHandle readPage(File* file, const PageId PageNo, LatchMode mode, BufGrant* grant = NULL,
+                      BufAccessStrategy* strategy = NULL);
+
+  /**
+   * Reads the given page for a scan. A page that is not in the buffer pool is read into the scan's ring of
+   * frames, so the scan does not push the rest of the pool's pages out.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @param strategy  	Access strategy returned by getAccessStrategy()
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   */
+  void readPage(File* file, const PageId PageNo, Page*& page, BufAccessStrategy* strategy);
+
+  /**
+   * Pins a page of a memory mapped file. The page is built straight from the mapping instead of being read into
+   * a frame, so the file's pages are only cached once, by the kernel. Mapped pages are read-only and never take
+   * a frame of the pool away from other files.
+   *
+   * @param file   	Mapped file
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer, set to the page, which stays valid while it is pinned
+   * @throws InvalidPageException If the file has no such page
+   */
+  void readPage(MappedFile* file, const PageId PageNo, const Page*& page);
+
+  /**
+   * Unpins a page of a memory mapped file
+   *
+   * @param file   	Mapped file
+   * @param PageNo  Page number
+   * @throws  PageNotPinnedException If the page is not pinned
+   */
+  void unPinPage(MappedFile* file, const PageId PageNo);
+
+  /**
+   * Creates an access strategy for one large sequential scan.
+   *
+   * @param ringSize   	Number of frames the scan may recycle, at least 1 and at most the size of the pool
+   * @return  The strategy, to be handed back with freeAccessStrategy()
+   */
+  BufAccessStrategy* getAccessStrategy(std::uint32_t ringSize);
+
+  /**
+   * Deletes an access strategy. Pages of its ring stay in the buffer pool and are left to the clock.
+   *
+   * @param strategy   	Strategy returned by getAccessStrategy()
+   */
+  void freeAccessStrategy(BufAccessStrategy* strategy);
+
+  /**
+   * Unpin a page from memory since it is no longer required for it to remain in memory.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number
+   * @param dirty		True if the page to be unpinned needs to be marked dirty	
+   * @throws  PageNotPinnedException If the page is not already pinned
+   */
+  void unPinPage(File* file, const PageId PageNo, const bool dirty);
+
+  /**
+   * Release the latch on a page read with readPage(File*, const PageId, Page*&, LatchMode) and unpin it.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number
+   * @param dirty		True if the page to be unpinned needs to be marked dirty	
+   * @param mode		Mode the page was latched in
+   * @throws  PageNotPinnedException If the page is not already pinned
+   * @throws  LatchNotHeldException If the page is not latched in the given mode, nothing is released then
+   */
+  void unPinPage(File* file, const PageId PageNo, const bool dirty, LatchMode mode);
+
+  /**
+   * Turn the shared latch held on a pinned page into an exclusive one. Only succeeds if no other thread holds the latch.
+   *
+   * @param page  	Page in the buffer pool, latched shared by the caller
+   * @return  True if the caller now holds the latch exclusively
+   */
+  bool tryUpgradeLatch(Page* page);
+
+  /**
+   * Turn the exclusive latch held on a pinned page into a shared one
+   *
+   * @param page  	Page in the buffer pool, latched exclusively by the caller
+   */
+  void downgradeLatch(Page* page);
+
+  /**
+   * Reads the page named by a page reference like readPage(File*, const PageId, Page*&). If the reference is
+   * swizzled its frame is pinned directly; otherwise the page is looked up as usual and the reference is swizzled
+   * to its frame, unless another reference already is. Unpin with unPinPage() as for any other page.
+   *
+   * @param ref   	Reference to the page
+   * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   */
+  void readPage(PageRef& ref, Page*& page);
+
+  /**
+   * Reads and latches the page named by a page reference, returning a handle for it. With a swizzled reference
+   * neither the read nor the unpin touches the hash table.
+   *
+   * @param ref   	Reference to the page
+   * @param mode  	Mode to latch the page contents in
+   * @return  Handle holding the pin and the latch on the page
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   */
+  PageHandle readPage(PageRef& ref, LatchMode mode);
+
+  /**
+   * Starts an optimistic read of the given page: the page is brought into the buffer pool if needed, but is returned
+   * neither pinned nor latched. The caller reads the page and then calls validatePage() with the returned version;
+   * if that fails the page was changed or evicted while it was being read, and the read has to be retried or done
+   * under a shared latch. The pointer and version can be kept to re-read the page later without going through
+   * the hash table, for as long as validatePage() keeps succeeding.
+   *
+   * Only writers that hold the page latched exclusively are noticed, so pages read this way must only be modified
+   * under LATCH_EXCLUSIVE. Copy what is read into local variables and do not act on it before it is validated.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number in the file to be read
+   * @param page  	Reference to page pointer. Used to fetch the Page object in which requested page from file is read in.
+   * @return  Version to validate the read against
+   * @throws BufferExceededException If the page is not in the buffer pool and every frame is pinned
+   */
+  std::uint64_t readPageOptimistic(File* file, const PageId PageNo, Page*& page);
+
+  /**
+   * Checks that a page read optimistically was neither written nor evicted since its version was taken
+   *
+   * @param page  	Page returned by readPageOptimistic()
+   * @param version  Version returned by readPageOptimistic()
+   * @return  True if everything read from the page since then is consistent
+   */
+  bool validatePage(const Page* page, std::uint64_t version) const
+  {
+    return bufDescTable[frameOf(page)].latch.validate(version);
+  }
+
+  /**
+   * Allocates a new, empty page in the file and returns the Page object.
+   * The newly allocated page is also assigned a frame in the buffer pool.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+   * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+   */
+  void allocPage(File* file, PageId &PageNo, Page*& page);
+
+  /**
+   * Allocates a new page like allocPage(File*, PageId&, Page*&), charging its frame to a frame reservation.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+   * @param page  	Reference to page pointer. The newly allocated in-memory Page object is returned via this reference.
+   * @param grant  	Frame reservation to charge the page to, NULL for the unreserved part of the pool
+   * @throws BufferExceededException If every frame is pinned or the grant has no frame left
+   */
+  void allocPage(File* file, PageId &PageNo, Page*& page, BufGrant* grant);
+
+  /**
+   * Allocates a new page like allocPage(File*, PageId&, Page*&), but returns a handle that unpins the page
+   * when it goes out of scope.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number. The number assigned to the page in the file is returned via this reference.
+   * @param grant  	Frame reservation to charge the page to, NULL for the unreserved part of the pool
+   * @return  Handle holding the pin on the new page
+   */
+  PageHandle allocPage(File* file, PageId &PageNo, BufGrant* grant = NULL);
+
+  /**
+   * Allocates a run of new pages in the file and pins each of them in a frame. All frames are taken in one
+   * pass of the clock before any page is allocated in the file, and the pages are then entered in the hash
+   * table one after another under a single acquisition of the pool lock. Either all pages are allocated or none:
+   * if a frame cannot be found, a victim cannot be written back or the file fails to allocate a page, the frames
+   * go back to the pool and the pages already allocated are deleted from the file again.
+   * Does not wait for frames to be unpinned, even if a frame wait timeout is set.
+   *
+   * @param file   	File object
+   * @param count   	Number of pages to allocate
+   * @param pageNos   	The numbers assigned to the pages in the file are returned via this vector
+   * @param pages   	The pages, in the same order as pageNos, are returned via this vector
+   * @param grant  	Frame reservation to charge the pages to, NULL for the unreserved part of the pool
+   * @throws BufferExceededException If there are not enough frames left to pin all the pages
+   * @throws BadgerDbException Whatever the file threw while writing a victim back or allocating a page
+   */
+  void allocPages(File* file, std::uint32_t count, std::vector<PageId>& pageNos, std::vector<Page*>& pages,
+                  BufGrant* grant = NULL);
+
+  /**
+   * Reads a run of consecutive pages of a file into consecutive frames and pins all of them, so the run can be
+   * used as one large page of pages * Page::SIZE bytes, for example for blob or overflow data. The frames of a
+   * run start at a multiple of the run size rounded up to a power of two, which keeps runs of one size from
+   * fragmenting the pool for each other. Pages of the run that are resident elsewhere are moved into the run.
+   * The pages stay ordinary pages: each one can also be read and unpinned on its own.
+   * Does not wait for frames to be unpinned, even if a frame wait timeout is set.
+   *
+   * @param file   	File object
+   * @param first   	Page number of the first page of the run
+   * @param pages   	Number of pages in the run
+   * @param run   	Set to the first page of the run, the others follow it in memory
+   * @throws BufferExceededException If the run is larger than the pool or no run of frames is free
+   * @throws PagePinnedException If a page of the run is pinned outside of a run of frames that holds it already
+   */
+  void readRun(File* file, const PageId first, std::uint32_t pages, Page*& run);
+
+  /**
+   * Unpins every page of a run read with readRun()
+   *
+   * @param file   	File object
+   * @param first   	Page number of the first page of the run
+   * @param pages   	Number of pages in the run
+   * @param dirty		True if the pages need to be marked dirty
+   * @throws  PageNotPinnedException If a page of the run is not pinned
+   */
+  void unPinRun(File* file, const PageId first, std::uint32_t pages, const bool dirty);
+
+  /**
+   * Writes out all dirty pages of the file to disk.
+   * All the frames assigned to the file need to be unpinned from buffer pool before this function can be successfully called.
+   * Otherwise Error returned.
+   * With a compressed store attached, pages go to the store and the store is synced, then the file's copies of
+   * the pages it holds are released, see setCompressedStore().
+   * Pages of the file waiting for the background writer are taken off its queue, and a write of the file it is
+   * in the middle of is waited for, so the file can be closed afterwards.
+   *
+   * @param file   	File object
+   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool 
+   * @throws BadBufferException If any frame allocated to the file is found to be invalid
+   */
+  void flushFile(const File* file);
+
+  /**
+   * Delete page from file and also from buffer pool if present.
+   * Since the page is entirely deleted from file, its unnecessary to see if the page is dirty.
+   *
+   * @param file   	File object
+   * @param PageNo  Page number
+   * @throws  PagePinnedException If the page is pinned in the buffer pool, it is left alone then
+   * @throws BadgerDbException If the last background batch failed to delete a page, this page is left alone
+   *         then and the pages of the batch that were not deleted are collected again
+   */
+  void disposePage(File* file, const PageId PageNo);
+
+  /**
+   * Drops every page of the file from the buffer pool in one pass, without writing dirty pages back.
+   * Meant for a file that is about to be removed or rebuilt, such as a dropped index. Disposed pages of the
+   * file that are still waiting to be deleted from it are forgotten, and so are the checksums of its pages.
+   * A compressed store attached to the file is emptied. Like flushFile(), waits for the background writer to
+   * be done with the file.
+   *
+   * @param file   	File object
+   * @throws  PagePinnedException If any page of the file is pinned in the buffer pool, nothing is dropped then
+   * @throws BadgerDbException If the last background batch failed to delete a page, nothing is dropped then
+   */
+  void disposeFile(const File* file);
+
+  /**
+   * Makes disposePage() drop the frame right away but collect the page, and delete collected pages from their
+   * files in the background once the given number of them has built up. A page must not be read again after it
+   * was disposed, whether or not it was deleted from its file yet.
+   *
+   * @param pages   	Number of pages deleted together, 0 to delete each page in disposePage() as before
+   */
+  void setDisposeBatch(std::uint32_t pages);
+
+  /**
+   * Waits for the background deletion of disposed pages, and deletes the pages still collected. Pages that
+   * cannot be deleted stay collected for the next try.
+   *
+   * @throws InvalidPageException If one of the disposed pages does not exist in its file, or the background
+   *         deletion ran into one
+   */
+  void drainDisposeQueue();
+
+  /**
+   * Makes the clock prefer clean frames. When the frame the clock would take is dirty, it is handed to a background
+   * writer and the clock goes on looking for a clean one, passing at most the given number of frames. Once
+   * maxQueued frames wait for the writer, or no clean frame turns up within the distance, a dirty frame is written
+   * back on the miss path as before.
+   *
+   * @param distance   	Number of frames the clock passes looking for a clean one, 0 to take the first one as before
+   * @param maxQueued   	Number of dirty frames that may wait for the writer
+   */
+  void setCleanVictimSearch(std::uint32_t distance, std::uint32_t maxQueued = 64);
+
+  /**
+   * Print member variable values. 
+   */
+  void  printSelf();
+
+  /**
+   * Writes the list of pages resident in the buffer pool to a file, one "filename, page number, refbit" entry
+   * per line. The list can be handed to warmUp() after a restart.
+   *
+   * @param path   	Name of the file the list is written to
+   * @return  True if the list was written, false if the file could not be opened
+   */
+  bool saveResidentPages(const std::string& path);
+
+  /**
+   * Loads the pages in a resident page list written by saveResidentPages() into free frames of the buffer pool.
+   * Pages are read with one reader per file, in page number order, each the way a miss reads it: bufMutex is
+   * only held around it, so the pool stays usable while it warms up. Recently referenced pages are loaded first
+   * if the list holds more pages than there are free frames. Loaded pages are left unpinned.
+   * Entries whose file is not in files, or whose page no longer exists, are skipped.
+   *
+   * @param path   	Name of the file holding the resident page list
+   * @param files  	Open files the entries in the list may refer to, matched by file name
+   * @return  Number of pages loaded into the buffer pool
+   */
+  std::uint32_t warmUp(const std::string& path, const std::vector<File*>& files);
+
+  /**
+   * Sets the file the resident page list is written to when the buffer manager is destroyed.
+   *
+   * @param path   	Name of the file, or an empty string to disable writing the list
+   */
+  void setResidentListPath(const std::string& path)
+  {
+    residentListPath = path;
+  }
+
+  /**
+   * Get a copy of the buffer pool usage statistics, taken under the buffer manager's mutex. The per-file
+   * hit counts only cover pages that have left the buffer pool; use getBufStatsSnapshot() to include the
+   * pages that are still resident.
+   */
+  BufStats getBufStats();
+
+  /**
+   * Get a copy of the buffer pool usage statistics with the hits on resident pages included
+   */
+  BufStats getBufStatsSnapshot();
+
+  /**
+   * Clear buffer pool usage statistics
+   */
+  void clearBufStats();
+
+  /**
+   * Get a copy of the latency histograms, taken under the buffer manager's mutex. They are only filled
+   * while latency tracking is enabled.
+   */
+  BufLatency getBufLatency();
+
+  /**
+   * Clear the latency histograms
+   */
+  void clearBufLatency();
+
+  /**
+   * Reserves frames for one client. Pages read or allocated with the returned grant are charged to it, so the client
+   * can always pin that many frames no matter what everyone else does. Reservations never cut into the unreserved
+   * headroom set with setUnreservedHeadroom().
+   *
+   * @param frames   	Number of frames to reserve
+   * @return  The grant, to be handed back with releaseGrant()
+   * @throws BufferExceededException If the frames are not available for reservation
+   */
+  BufGrant* reserveFrames(std::uint32_t frames);
+
+  /**
+   * Gives the frames of a reservation back to the pool and deletes the grant.
+   *
+   * @param grant   	Grant returned by reserveFrames()
+   * @throws GrantPinnedException If frames charged to the grant are still pinned
+   */
+  void releaseGrant(BufGrant* grant);
+
+  /**
+   * Sets how many frames are kept out of reach of reservations, for the clients that pin without a grant.
+   *
+   * @param frames   	Number of frames that can never be reserved
+   */
+  void setUnreservedHeadroom(std::uint32_t frames)
+  {
+    std::lock_guard<Latching> lock(bufMutex);
+    unreservedHeadroom = frames;
+  }
+
+  /**
+   * Sets how long a thread that needs a frame while every frame is pinned waits for another thread to unpin one,
+   * instead of failing with BufferExceededException right away. Waiting threads get frames in arrival order.
+   *
+   * @param timeout   	Longest wait, zero to fail immediately as before
+   */
+  void setFrameWaitTimeout(std::chrono::milliseconds timeout)
+  {
+    std::lock_guard<Latching> lock(bufMutex);
+    frameWaitTimeout = timeout;
+  }
+
+  /**
+   * Turn timing of readPage(), allocBuf() and disk I/O on or off. Off by default, since timing costs
+   * two clock reads per call.
+   *
+   * @param enabled   	True to start recording latencies
+   */
+  void setLatencyTracking(bool enabled)
+  {
+    std::lock_guard<Latching> lock(bufMutex);
+    latencyTracking = enabled;
+  }
+
+  /**
+   * Gives the pool a second tier in memory that keeps evicted pages LZ4 compressed, and that misses are
+   * served from before the file is read. Pages evicted out of a scan's ring do not go there.
+   *
+   * @param bytes   	Most bytes of compressed pages kept, 0 to drop the tier
+   */
+  void setSecondTier(std::size_t bytes);
+
+  /**
+   * Puts a cache file on a fast local device, such as an SSD, behind the pool. Evicted pages are written to it
+   * and misses read them from there instead of from their files on slower storage. Pages evicted out of a scan's
+   * ring are not admitted. A page written back to its file is dropped from the cache until it is evicted again.
+   *
+   * @param path   	Path of the cache file, empty to drop the cache
+   * @param pages   	Number of pages the cache holds
+   * @throws FlashCacheException If the cache file cannot be created
+   */
+  void setFlashCache(const std::string& path, std::uint32_t pages);
+
+  /**
+   * Puts a compressed store next to a file. Pages of the file written back from now on are compressed into the
+   * store instead of being written to the file, and reads look in the store first, so pages that were never
+   * written back since are still read from the file. flushFile() syncs the store. Pages going to a store skip the
+   * double-write area, the store never overwrites a live page. disposeFile() empties the store.
+   *
+   * WARNING: the file is not kept up to date. It keeps allocating page numbers and File::allocatePage() writes
+   * each new page to it empty. Once flushFile() synced the store, the data of every page in it is punched out of
+   * a PageFile, only the page headers stay; until then the file holds stale copies. The file must only be read
+   * through this buffer manager with the store attached, never directly, through another pool, a MappedFile
+   * or exportFile(), and the store must not be taken off it again while it holds pages.
+   *
+   * @param file   	File object
+   * @param store   	Store for the pages of the file, owned by the caller and kept until the buffer manager is deleted;
+   *                	NULL to write to the file itself again once the store is empty
+   */
+  void setCompressedStore(const File* file, CompressedPageStore* store);
+
+  /**
+   * Sends written back pages through a double-write area, so a crash while writing a page in place cannot tear it.
+   * Pages are collected and written together once the batch is full, when a file is flushed and when the
+   * buffer manager is deleted. A full batch is written by a background task, unless the pool is single-threaded;
+   * an error it runs into leaves the pages in the batch and is reported by the next flushFile().
+   * Run DoubleWriteBuffer::recover() on the area at startup before this.
+   *
+   * @param path   	Path of the double-write area, empty to write pages in place directly again
+   * @param pages   	Number of pages written together
+   * @throws DoubleWriteException If the area cannot be created
+   */
+  void setDoubleWrite(const std::string& path, std::uint32_t pages);
+
+  /**
+   * Turn page checksums on or off. On by default. While on, every page written back gets a CRC32C in the
+   * checksum file next to its file, see ChecksumFile, and every page read from disk is checked against the
+   * CRC it was last written with. The CRCs outlive the buffer manager and are shared by every pool using the
+   * file. While off, pages are written without a CRC and their old one is forgotten, and reads are not checked.
+   *
+   * @param enabled   	True to checksum pages
+   */
+  void setChecksums(bool enabled)
+  {
+    std::lock_guard<Latching> lock(bufMutex);
+    checksumsEnabled = enabled;
+  }
+
+  /**
+   * Drop the checksums of all pages of a file, for when the file is about to be written by something other
+   * than a buffer pool. Its pages are then read without a check until they are written back again.
+   *
+   * @param file   	File object
+   * @throws ChecksumFileException If the checksum file cannot be truncated
+   */
+  void forgetChecksums(const File* file);
+};
+
+//defined in buffer.cpp
+extern template class BasicPageRef<BasicBufMgr<ClockReplacement, std::mutex> >;
+extern template class BasicPageHandle<BasicBufMgr<ClockReplacement, std::mutex> >;
+extern template class BasicBufMgr<ClockReplacement, std::mutex>;
+extern template class BasicPageRef<BasicBufMgr<ClockReplacement, NullMutex> >;
+extern template class BasicPageHandle<BasicBufMgr<ClockReplacement, NullMutex> >;
+extern template class BasicBufMgr<ClockReplacement, NullMutex>;
+
+}
@@ -0,0 +1,194 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include "bulkLoader.h"
+#include "file_iterator.h"
+#include "pageImage.h"
+#include "exceptions/bulk_load_exception.h"
+
+namespace badgerdb {
+
+/*
+ * The header is read once; nobody else allocates pages in the file while it is loaded, so the numbers
+ * past its end stay ours.
+ */
+BulkLoader::BulkLoader(File* fileIn, std::uint32_t runPagesIn)
+	: file(fileIn), fd(-1), runPages(runPagesIn > 0 ? runPagesIn : 1), runCount(0), runStart(Page::INVALID_NUMBER),
+	  written(0), pending(false), finished(false), checksums(NULL)
+{
+	if(dynamic_cast<PageFile*>(file) != NULL) {
+		fd = ::open(file->filename().c_str(), O_RDWR);
+		if(fd < 0) {
+			throw BulkLoadException(file->filename(), "open");
+		}
+		if(::pread(fd, &header, sizeof(FileHeader), 0) != (ssize_t) sizeof(FileHeader)) {
+			::close(fd);
+			throw BulkLoadException(file->filename(), "read the file header");
+		}
+		runStart = header.num_pages;
+		run.resize((std::size_t) runPages * Page::SIZE);
+	}
+	else if(ChecksumFile::exists(file->filename())) {
+		checksums = new ChecksumFile(file->filename());
+	}
+}
+
+/*
+ * A load that is dropped without a commit must not leave half a file behind.
+ */
+BulkLoader::~BulkLoader()
+{
+	if(!finished) {
+		try {
+			abort();
+		} catch(...) {
+		}
+	}
+	if(fd >= 0) {
+		::close(fd);
+	}
+	delete checksums;
+}
+
+void BulkLoader::writeCurrent()
+{
+	if(pending) {
+		file->writePage(current);
+		pending = false;
+	}
+}
+
+void BulkLoader::stageCurrent(PageId next)
+{
+	if(pending) {
+		char* image = &run[(std::size_t) runCount * Page::SIZE];
+		pageToImage(current, image);
+		PageHeader pageHeader;
+		std::memcpy(&pageHeader, image, sizeof(PageHeader));
+		pageHeader.next_page_number = next;
+		std::memcpy(image, &pageHeader, sizeof(PageHeader));
+		runCount++;
+		pending = false;
+	}
+}
+
+/*
+ * The pages go first and the header last, so the header never takes in a page that is not there. The pages
+ * of a run link to each other already, and the first run is linked to the last used page of the file, which
+ * is the last one in its list as every used page comes before the pages past the end.
+ */
+void BulkLoader::writeRun()
+{
+	if(runCount == 0) {
+		return;
+	}
+
+	std::size_t bytes = (std::size_t) runCount * Page::SIZE;
+	if(::pwrite(fd, &run[0], bytes, pageFileOffset(runStart)) != (ssize_t) bytes) {
+		throw BulkLoadException(file->filename(), "write a run of pages");
+	}
+
+	if(header.first_used_page == Page::INVALID_NUMBER) {
+		header.first_used_page = runStart;
+	}
+	else if(written == 0) {
+		PageId last = Page::INVALID_NUMBER;
+		for(FileIterator it = file->begin(); it != file->end(); ++it) {
+			Page page = *it;
+			if(page.next_page_number() == Page::INVALID_NUMBER) {
+				last = page.page_number();
+				break;
+			}
+		}
+		if(last != Page::INVALID_NUMBER) {
+			PageHeader pageHeader;
+			if(::pread(fd, &pageHeader, sizeof(PageHeader), pageFileOffset(last)) != (ssize_t) sizeof(PageHeader)) {
+				throw BulkLoadException(file->filename(), "read the last used page");
+			}
+			pageHeader.next_page_number = runStart;
+			if(::pwrite(fd, &pageHeader, sizeof(PageHeader), pageFileOffset(last)) != (ssize_t) sizeof(PageHeader)) {
+				throw BulkLoadException(file->filename(), "link the last used page");
+			}
+		}
+	}
+
+	header.num_pages = runStart + runCount;
+	if(::pwrite(fd, &header, sizeof(FileHeader), 0) != (ssize_t) sizeof(FileHeader)) {
+		throw BulkLoadException(file->filename(), "write the file header");
+	}
+
+	written += runCount;
+	runStart += runCount;
+	runCount = 0;
+}
+
+/*
+ * The new page is built in the run slot it is going to be put in, so it already carries its number.
+ */
+Page* BulkLoader::newPage(PageId& pageNo)
+{
+	if(fd < 0) {
+		writeCurrent();
+		current = file->allocatePage();
+		pageNo = current.page_number();
+		if(checksums != NULL) {
+			checksums->forget(pageNo);
+		}
+	}
+	else {
+		pageNo = runStart + runCount + (pending ? 1 : 0);
+		stageCurrent(pageNo);
+		if(runCount == runPages) {
+			writeRun();
+		}
+
+		char* image = &run[(std::size_t) runCount * Page::SIZE];
+		pageToImage(Page(), image);
+		PageHeader pageHeader;
+		std::memcpy(&pageHeader, image, sizeof(PageHeader));
+		pageHeader.current_page_number = pageNo;
+		std::memcpy(image, &pageHeader, sizeof(PageHeader));
+		pageFromImage(image, current);
+	}
+
+	pending = true;
+	allocated.push_back(pageNo);
+	return &current;
+}
+
+void BulkLoader::commit()
+{
+	if(fd < 0) {
+		writeCurrent();
+	}
+	else {
+		stageCurrent(Page::INVALID_NUMBER);
+		writeRun();
+	}
+	finished = true;
+}
+
+/*
+ * Pages that never made it to a PageFile are not in it, only those written are deleted.
+ */
+void BulkLoader::abort()
+{
+	pending = false;
+	runCount = 0;
+	std::size_t inFile = fd < 0 ? allocated.size() : written;
+	for(std::size_t i = 0; i < inFile; i++) {
+		file->deletePage(allocated[i]);
+	}
+	allocated.clear();
+	written = 0;
+	finished = true;
+}
+
+}
@@ -0,0 +1,169 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <vector>
+#include "file.h"
+#include "checksumFile.h"
+
+namespace badgerdb {
+
+/**
+* @brief Fills a new file with pages without going through a buffer pool.
+*
+* allocPage() on the buffer manager runs every page of a load through frame allocation and the hash table, and a
+* large load pushes the pool's hot pages out on the way. A BulkLoader builds pages in a buffer of its own, so the pool
+* is never touched. Nothing of the load is known to any buffer pool, and the file must not be read through one, nor
+* have pages allocated in it, until commit() returns.
+*
+* For a PageFile the loader takes the page numbers past the end of the file, the way File::allocatePage() does when
+* the file has no free pages, without writing anything yet. Filled pages are collected into runs of consecutive
+* pages, and each run goes to the file in one write, followed by the file header that takes the run in. The empty
+* page File::allocatePage() writes first is never written. Free pages of the file are left alone, and since the page
+* numbers past the end were never used in the file, they have no checksums to forget.
+*
+* Any other File gets its pages from File::allocatePage(), which writes each one out empty, and each page is written
+* again once it is filled. Those pages may come off the file's free list, so their checksums are forgotten.
+*/
+class BulkLoader
+{
+ private:
+  /**
+   * File being loaded
+   */
+  File* file;
+
+  /**
+   * Descriptor the pages of a PageFile are written through, -1 for another File
+   */
+  int fd;
+
+  /**
+   * Header of the PageFile as it is on disk, updated after every run
+   */
+  FileHeader header;
+
+  /**
+   * Images of the filled pages not written yet, one run of them
+   */
+  std::vector<char> run;
+
+  /**
+   * Number of pages a run holds at most
+   */
+  std::uint32_t runPages;
+
+  /**
+   * Number of pages in run
+   */
+  std::uint32_t runCount;
+
+  /**
+   * Number of the first page in run
+   */
+  PageId runStart;
+
+  /**
+   * Number of pages of the load already in the file
+   */
+  std::uint32_t written;
+
+  /**
+   * Page being filled by the caller
+   */
+  Page current;
+
+  /**
+   * True while current holds a page that has not been written yet
+   */
+  bool pending;
+
+  /**
+   * Every page allocated in the file by this load, so abort() can give them back
+   */
+  std::vector<PageId> allocated;
+
+  /**
+   * True once the load was committed or aborted
+   */
+  bool finished;
+
+  /**
+   * Checksum file of the file, NULL if it has none
+   */
+  ChecksumFile* checksums;
+
+  /**
+   * Write the page being filled to the file, if there is one. Only for a File that is not a PageFile.
+   */
+  void writeCurrent();
+
+  /**
+   * Put the page being filled into the run as the next page in it, if there is one
+   *
+   * @param next   	Number of the page that follows it in the file's list of used pages, Page::INVALID_NUMBER for none
+   */
+  void stageCurrent(PageId next);
+
+  /**
+   * Write the run to the file in one write, link it to the pages before it and write the file header
+   *
+   * @throws BulkLoadException If the file cannot be read or written
+   */
+  void writeRun();
+
+  BulkLoader(const BulkLoader&) = delete;
+  BulkLoader& operator=(const BulkLoader&) = delete;
+
+ public:
+  /**
+   * Constructor of BulkLoader class
+   *
+   * @param fileIn   	File to load, normally one that was just created
+   * @param runPagesIn   	Number of pages written to a PageFile at a time
+   * @throws BulkLoadException If the file header of a PageFile cannot be read
+   */
+  explicit BulkLoader(File* fileIn, std::uint32_t runPagesIn = 32);
+
+  /**
+   * Destructor of BulkLoader class. Aborts the load unless it was committed.
+   */
+  ~BulkLoader();
+
+  /**
+   * Puts away the page filled so far, allocates a new page in the file and returns it for the caller to fill in.
+   * The page can only be filled until the next call to newPage(), commit() or abort().
+   *
+   * @param pageNo   	The number assigned to the page in the file is returned via this reference
+   * @return  The page, in the loader's own buffer
+   * @throws BulkLoadException If a full run cannot be written
+   */
+  Page* newPage(PageId& pageNo);
+
+  /**
+   * Writes out the pages not written yet. The loaded pages can be read through a buffer pool afterwards.
+   *
+   * @throws BulkLoadException If the last run cannot be written
+   */
+  void commit();
+
+  /**
+   * Drops the pages not written yet and deletes every page of the load that was from the file.
+   */
+  void abort();
+
+  /**
+   * Number of pages allocated by the load so far
+   */
+  std::uint32_t pageCount() const
+  {
+    return (std::uint32_t) allocated.size();
+  }
+};
+
+}
@@ -0,0 +1,143 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "checksumFile.h"
+#include "exceptions/checksum_file_exception.h"
+
+namespace badgerdb {
+
+bool ChecksumFile::exists(const std::string& dataPath)
+{
+	return ::access(pathFor(dataPath).c_str(), F_OK) == 0;
+}
+
+void ChecksumFile::remove(const std::string& dataPath)
+{
+	::unlink(pathFor(dataPath).c_str());
+}
+
+/*
+ * The creation time comes from statx where the file system has one. Without it the identity is only the
+ * device and inode, which is the best stat can do.
+ */
+void ChecksumFile::identify(const std::string& dataPath, Header& header)
+{
+	header = Header();
+	header.magic = HEADER_MAGIC;
+#ifdef STATX_BTIME
+	struct statx info;
+	if(::statx(AT_FDCWD, dataPath.c_str(), 0, STATX_INO | STATX_BTIME, &info) != 0) {
+		throw ChecksumFileException(dataPath, "identify the data file");
+	}
+	header.device = ((std::uint64_t) info.stx_dev_major << 32) | info.stx_dev_minor;
+	header.inode = info.stx_ino;
+	if(info.stx_mask & STATX_BTIME) {
+		header.birthSeconds = info.stx_btime.tv_sec;
+		header.birthNanos = info.stx_btime.tv_nsec;
+	}
+#else
+	struct stat info;
+	if(::stat(dataPath.c_str(), &info) != 0) {
+		throw ChecksumFileException(dataPath, "identify the data file");
+	}
+	header.device = info.st_dev;
+	header.inode = info.st_ino;
+#endif
+}
+
+/*
+ * A file without a header, or with one naming another data file, is started over.
+ */
+ChecksumFile::ChecksumFile(const std::string& dataPath)
+	: path(pathFor(dataPath))
+{
+	Header expected;
+	identify(dataPath, expected);
+
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if(fd < 0) {
+		throw ChecksumFileException(path, "open");
+	}
+
+	Header found = Header();
+	ssize_t read = ::pread(fd, &found, sizeof(Header), 0);
+	if(read != (ssize_t) sizeof(Header) || found.magic != expected.magic || found.device != expected.device ||
+			found.inode != expected.inode || found.birthSeconds != expected.birthSeconds || found.birthNanos != expected.birthNanos) {
+		try {
+			reset(expected);
+		} catch(ChecksumFileException& e) {
+			::close(fd);
+			throw;
+		}
+	}
+}
+
+void ChecksumFile::reset(const Header& header)
+{
+	if(::ftruncate(fd, 0) != 0) {
+		throw ChecksumFileException(path, "truncate");
+	}
+	if(::pwrite(fd, &header, sizeof(Header), 0) != (ssize_t) sizeof(Header)) {
+		throw ChecksumFileException(path, "write the header");
+	}
+}
+
+ChecksumFile::~ChecksumFile()
+{
+	::close(fd);
+}
+
+/*
+ * Past the end of the file, or in a hole, the entry reads as zeros and so is not set.
+ */
+bool ChecksumFile::lookup(const PageId pageNo, std::uint32_t& crc) const
+{
+	Entry entry = { 0, 0 };
+	if(::pread(fd, &entry, sizeof(Entry), entryOffset(pageNo)) < 0) {
+		throw ChecksumFileException(path, "read a checksum");
+	}
+	if(entry.magic != MAGIC) {
+		return false;
+	}
+	crc = entry.crc;
+	return true;
+}
+
+void ChecksumFile::record(const PageId pageNo, std::uint32_t crc)
+{
+	Entry entry = { crc, MAGIC };
+	if(::pwrite(fd, &entry, sizeof(Entry), entryOffset(pageNo)) != (ssize_t) sizeof(Entry)) {
+		throw ChecksumFileException(path, "write a checksum");
+	}
+}
+
+void ChecksumFile::forget(const PageId pageNo)
+{
+	Entry entry = { 0, 0 };
+	if(::pwrite(fd, &entry, sizeof(Entry), entryOffset(pageNo)) != (ssize_t) sizeof(Entry)) {
+		throw ChecksumFileException(path, "clear a checksum");
+	}
+}
+
+void ChecksumFile::clear()
+{
+	if(::ftruncate(fd, sizeof(Header)) != 0) {
+		throw ChecksumFileException(path, "truncate");
+	}
+}
+
+void ChecksumFile::sync()
+{
+	if(::fdatasync(fd) != 0) {
+		throw ChecksumFileException(path, "sync");
+	}
+}
+
+}
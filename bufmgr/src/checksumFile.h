@@ -0,0 +1,188 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+* @brief The page checksums of a data file, kept in a file next to it.
+*
+* The checksum file of data file "name" is "name.crc". It is an array of 8 byte entries indexed by page number, each
+* the CRC32C of the page and a marker saying the entry is set. A page whose entry is not set, including one past the
+* end of the checksum file, has no checksum and is read without a check. Nothing of it is kept in memory, so it costs
+* the same whatever the size of the data file.
+*
+* An entry is written right after its page, and synced along with the data file, so it is as durable as the page.
+* A crash between the two leaves a page that does not match its entry, which is reported like any other mismatch.
+* Anything that writes pages of the data file without going through a buffer pool has to forget their entries.
+*
+* The entries are preceded by a header naming the data file they belong to by device, inode and creation time. A
+* checksum file left behind by a data file that was removed does not match a new file of the same name, and is
+* emptied when it is opened. Where the file system does not report creation times, a new file that reuses the
+* inode of the old one cannot be told apart from it, so removing the checksum file with its data file is still
+* the safe thing to do.
+*/
+class ChecksumFile
+{
+ private:
+  /**
+   * Marks an entry that holds a checksum
+   */
+  static const std::uint32_t MAGIC = 0x43524331;
+
+  /**
+   * What the file holds for each page
+   */
+  struct Entry
+  {
+    std::uint32_t crc;
+    std::uint32_t magic;
+  };
+
+  /**
+   * Marks the header
+   */
+  static const std::uint32_t HEADER_MAGIC = 0x43524348;
+
+  /**
+   * What the file starts with, the identity of the data file it belongs to
+   */
+  struct Header
+  {
+    std::uint32_t magic;
+    std::uint32_t birthNanos;
+    std::uint64_t device;
+    std::uint64_t inode;
+    std::int64_t birthSeconds;
+  };
+
+  /**
+   * Offset of the entry of a page
+   */
+  static off_t entryOffset(const PageId pageNo)
+  {
+    return (off_t) sizeof(Header) + (off_t) pageNo * sizeof(Entry);
+  }
+
+  /**
+   * Read the identity of a data file
+   *
+   * @param dataPath   	Path of the data file
+   * @param header   	The identity is returned via this reference
+   * @throws ChecksumFileException If the data file cannot be looked at
+   */
+  static void identify(const std::string& dataPath, Header& header);
+
+  /**
+   * Empty the file and write the header
+   *
+   * @param header   	Identity of the data file
+   * @throws ChecksumFileException If the file cannot be truncated or written
+   */
+  void reset(const Header& header);
+
+  /**
+   * Path of the checksum file
+   */
+  std::string path;
+
+  /**
+   * Descriptor of the checksum file
+   */
+  int fd;
+
+  ChecksumFile(const ChecksumFile&) = delete;
+  ChecksumFile& operator=(const ChecksumFile&) = delete;
+
+ public:
+  /**
+   * Path of the checksum file of a data file
+   *
+   * @param dataPath   	Path of the data file
+   */
+  static std::string pathFor(const std::string& dataPath)
+  {
+    return dataPath + ".crc";
+  }
+
+  /**
+   * Whether the data file has a checksum file
+   *
+   * @param dataPath   	Path of the data file
+   */
+  static bool exists(const std::string& dataPath);
+
+  /**
+   * Remove the checksum file of a data file, if it has one
+   *
+   * @param dataPath   	Path of the data file
+   */
+  static void remove(const std::string& dataPath);
+
+  /**
+   * Constructor of ChecksumFile class. Opens the checksum file of the data file, creating it if needed, and
+   * empties it if it was written for another file of the same name.
+   *
+   * @param dataPath   	Path of the data file, which has to exist
+   * @throws ChecksumFileException If the file cannot be opened, or the data file cannot be looked at
+   */
+  explicit ChecksumFile(const std::string& dataPath);
+
+  /**
+   * Destructor of ChecksumFile class. Closes the file without syncing it.
+   */
+  ~ChecksumFile();
+
+  /**
+   * Look up the checksum of a page
+   *
+   * @param pageNo   	Page number in the data file
+   * @param crc   	The checksum is returned via this reference
+   * @return  False if the page has no checksum
+   * @throws ChecksumFileException If the file cannot be read
+   */
+  bool lookup(const PageId pageNo, std::uint32_t& crc) const;
+
+  /**
+   * Set the checksum of a page
+   *
+   * @param pageNo   	Page number in the data file
+   * @param crc   	Checksum of the page as it was written
+   * @throws ChecksumFileException If the file cannot be written
+   */
+  void record(const PageId pageNo, std::uint32_t crc);
+
+  /**
+   * Clear the checksum of a page, which is read without a check until it is recorded again
+   *
+   * @param pageNo   	Page number in the data file
+   * @throws ChecksumFileException If the file cannot be written
+   */
+  void forget(const PageId pageNo);
+
+  /**
+   * Clear the checksums of all pages
+   *
+   * @throws ChecksumFileException If the file cannot be truncated
+   */
+  void clear();
+
+  /**
+   * Flush the checksums written so far to stable storage
+   *
+   * @throws ChecksumFileException If the file cannot be synced
+   */
+  void sync();
+};
+
+}
@@ -0,0 +1,91 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <lz4.h>
+#include "compressedCache.h"
+#include "pageImage.h"
+
+namespace badgerdb {
+
+/*
+ * Pages are compressed into a buffer of the worst case size first and only then copied into
+ * one of their own size, so the tier does not keep the slack.
+ */
+bool CompressedCache::put(const File* file, const Page& page)
+{
+	erase(file, page.page_number());
+
+	std::vector<char> image(Page::SIZE);
+	pageToImage(page, &image[0]);
+	std::vector<char> buffer(LZ4_compressBound(Page::SIZE));
+	int length = LZ4_compress_default(&image[0], &buffer[0], Page::SIZE, (int) buffer.size());
+	if(length <= 0 || length >= (int) Page::SIZE || (std::size_t) length > capacityBytes) {
+		return false;
+	}
+
+	while(usedBytes + length > capacityBytes) {
+		usedBytes -= entries.back().data.size();
+		index.erase(entries.back().key);
+		entries.pop_back();
+	}
+
+	Entry entry;
+	entry.key.file = file;
+	entry.key.pageNo = page.page_number();
+	entry.data.assign(buffer.begin(), buffer.begin() + length);
+	entries.push_front(entry);
+	index[entry.key] = entries.begin();
+	usedBytes += length;
+	return true;
+}
+
+bool CompressedCache::take(const File* file, const PageId pageNo, Page& page)
+{
+	PageKey key = { file, pageNo };
+	std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash>::iterator it = index.find(key);
+	if(it == index.end()) {
+		return false;
+	}
+
+	const std::vector<char>& data = it->second->data;
+	std::vector<char> image(Page::SIZE);
+	bool ok = LZ4_decompress_safe(&data[0], &image[0], (int) data.size(), Page::SIZE) == (int) Page::SIZE;
+	if(ok) {
+		pageFromImage(&image[0], page);
+	}
+	usedBytes -= data.size();
+	entries.erase(it->second);
+	index.erase(it);
+	return ok;
+}
+
+void CompressedCache::erase(const File* file, const PageId pageNo)
+{
+	PageKey key = { file, pageNo };
+	std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash>::iterator it = index.find(key);
+	if(it != index.end()) {
+		usedBytes -= it->second->data.size();
+		entries.erase(it->second);
+		index.erase(it);
+	}
+}
+
+void CompressedCache::eraseFile(const File* file)
+{
+	for(std::list<Entry>::iterator it = entries.begin(); it != entries.end(); ) {
+		if(it->key.file == file) {
+			usedBytes -= it->data.size();
+			index.erase(it->key);
+			it = entries.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+}
@@ -0,0 +1,124 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "file.h"
+#include "pageKey.h"
+
+namespace badgerdb {
+
+/**
+* @brief Second tier of the buffer pool that keeps evicted pages LZ4 compressed in memory.
+*
+* The buffer manager puts a page in here when the clock evicts it, and takes it back out on a miss before going
+* to the file, so a page that compresses 3:1 costs a third of a frame while it waits. The tier holds at most
+* capacityBytes of compressed data and drops the least recently stored pages to make room. Pages that do not
+* compress are not kept. A page lives in at most one of the pool and the tier at a time.
+*/
+class CompressedCache
+{
+ private:
+  /**
+   * A compressed page
+   */
+  struct Entry
+  {
+    PageKey key;
+    std::vector<char> data;
+  };
+
+  /**
+   * Most bytes of compressed data kept
+   */
+  std::size_t capacityBytes;
+
+  /**
+   * Bytes of compressed data kept
+   */
+  std::size_t usedBytes;
+
+  /**
+   * Pages, most recently stored first
+   */
+  std::list<Entry> entries;
+
+  /**
+   * Position of every page in entries
+   */
+  std::unordered_map<PageKey, std::list<Entry>::iterator, PageKeyHash> index;
+
+  CompressedCache(const CompressedCache&) = delete;
+  CompressedCache& operator=(const CompressedCache&) = delete;
+
+ public:
+  /**
+   * Constructor of CompressedCache class
+   *
+   * @param capacityBytesIn   	Most bytes of compressed data kept
+   */
+  explicit CompressedCache(std::size_t capacityBytesIn)
+    : capacityBytes(capacityBytesIn), usedBytes(0)
+  {
+  }
+
+  /**
+   * Compresses a page and keeps it, replacing an older copy of the same page
+   *
+   * @param file   	File the page belongs to
+   * @param page   	The page
+   * @return  False if the page did not compress and was not kept
+   */
+  bool put(const File* file, const Page& page);
+
+  /**
+   * Takes a page out of the tier
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   * @param page   	The page is decompressed into here if it is in the tier
+   * @return  True if the page was in the tier
+   */
+  bool take(const File* file, const PageId pageNo, Page& page);
+
+  /**
+   * Drops a page from the tier
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   */
+  void erase(const File* file, const PageId pageNo);
+
+  /**
+   * Drops every page of a file from the tier
+   *
+   * @param file   	File object
+   */
+  void eraseFile(const File* file);
+
+  /**
+   * Number of pages kept
+   */
+  std::size_t size() const
+  {
+    return index.size();
+  }
+
+  /**
+   * Bytes of compressed data kept
+   */
+  std::size_t bytes() const
+  {
+    return usedBytes;
+  }
+};
+
+}
@@ -0,0 +1,379 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iterator>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <lz4.h>
+#include "compressedPageStore.h"
+#include "pageImage.h"
+#include "exceptions/compressed_store_exception.h"
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Layout of the mapping table: a header followed by one entry per page
+ */
+struct MapHeader
+{
+	std::uint32_t magic;
+	std::uint32_t reserved;
+	std::uint64_t endOffset;
+	std::uint64_t count;
+};
+
+struct MapEntry
+{
+	std::uint32_t pageNo;
+	std::uint32_t length;
+	std::uint32_t capacity;
+	std::uint32_t reserved;
+	std::uint64_t offset;
+};
+
+bool writeAll(int fd, const char* data, std::size_t length)
+{
+	while(length > 0) {
+		ssize_t n = ::write(fd, data, length);
+		if(n <= 0) {
+			return false;
+		}
+		data += n;
+		length -= n;
+	}
+	return true;
+}
+
+/**
+ * Adds a range to ranges, merged with the ranges that end where it starts and start where it ends. bySize, if
+ * given, indexes ranges by length and is kept in step.
+ */
+void mergeRange(std::map<std::uint64_t, std::uint64_t>& ranges, std::multimap<std::uint64_t, std::uint64_t>* bySize,
+	std::uint64_t offset, std::uint64_t length)
+{
+	std::vector<std::map<std::uint64_t, std::uint64_t>::iterator> merged;
+	std::map<std::uint64_t, std::uint64_t>::iterator next = ranges.lower_bound(offset);
+	if(next != ranges.end() && next->first == offset + length) {
+		length += next->second;
+		merged.push_back(next);
+	}
+	if(next != ranges.begin()) {
+		std::map<std::uint64_t, std::uint64_t>::iterator prev = std::prev(next);
+		if(prev->first + prev->second == offset) {
+			offset = prev->first;
+			length += prev->second;
+			merged.push_back(prev);
+		}
+	}
+
+	for(std::size_t i = 0; i < merged.size(); i++) {
+		if(bySize != NULL) {
+			std::pair<std::multimap<std::uint64_t, std::uint64_t>::iterator,
+				std::multimap<std::uint64_t, std::uint64_t>::iterator> same = bySize->equal_range(merged[i]->second);
+			for(std::multimap<std::uint64_t, std::uint64_t>::iterator it = same.first; it != same.second; ++it) {
+				if(it->second == merged[i]->first) {
+					bySize->erase(it);
+					break;
+				}
+			}
+		}
+		ranges.erase(merged[i]);
+	}
+	ranges[offset] = length;
+	if(bySize != NULL) {
+		bySize->insert(std::make_pair(length, offset));
+	}
+}
+
+}
+
+CompressedPageStore::CompressedPageStore(const std::string& pathIn)
+	: path(pathIn), endOffset(0), storedBytes(0)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+	if(fd < 0) {
+		throw CompressedStoreException(path, "open");
+	}
+	loadMap();
+}
+
+CompressedPageStore::~CompressedPageStore()
+{
+	try {
+		sync();
+	} catch(CompressedStoreException& e) {
+	}
+	::close(fd);
+}
+
+/*
+ * Whatever was written after the last sync is not in the table, so the gaps between the slots it lists,
+ * and everything past its end offset, are free space.
+ */
+void CompressedPageStore::loadMap()
+{
+	std::FILE* in = std::fopen((path + ".map").c_str(), "rb");
+	if(in == NULL) {
+		return;
+	}
+
+	MapHeader header;
+	if(std::fread(&header, sizeof(MapHeader), 1, in) != 1 || header.magic != MAGIC) {
+		std::fclose(in);
+		throw CompressedStoreException(path, "read its mapping table");
+	}
+
+	std::vector<std::pair<std::uint64_t, std::uint32_t> > used;
+	for(std::uint64_t i = 0; i < header.count; i++) {
+		MapEntry entry;
+		if(std::fread(&entry, sizeof(MapEntry), 1, in) != 1) {
+			std::fclose(in);
+			throw CompressedStoreException(path, "read its mapping table");
+		}
+		Slot slot = { entry.offset, entry.length, entry.capacity };
+		slots[entry.pageNo] = slot;
+		storedBytes += entry.length;
+		used.push_back(std::make_pair(entry.offset, entry.capacity));
+	}
+	std::fclose(in);
+
+	endOffset = header.endOffset;
+	std::sort(used.begin(), used.end());
+	std::uint64_t next = 0;
+	for(std::size_t i = 0; i < used.size(); i++) {
+		if(used[i].first > next) {
+			addFree(next, used[i].first - next);
+		}
+		next = used[i].first + used[i].second;
+	}
+
+	//the data file may have been cut off after the table was written, the end it recorded is past it then
+	struct stat st;
+	if(::fstat(fd, &st) == 0 && (std::uint64_t) st.st_size < endOffset) {
+		endOffset = std::max((std::uint64_t) st.st_size, next);
+	}
+	if(endOffset > next) {
+		addFree(next, endOffset - next);
+	}
+}
+
+/*
+ * Best fit among the free slots. Whatever the page does not need of a larger slot stays free.
+ */
+CompressedPageStore::Slot CompressedPageStore::takeSlot(std::uint32_t capacity)
+{
+	Slot slot;
+	slot.capacity = capacity;
+
+	std::multimap<std::uint64_t, std::uint64_t>::iterator it = freeBySize.lower_bound(capacity);
+	if(it != freeBySize.end()) {
+		slot.offset = it->second;
+		std::uint64_t left = it->first - capacity;
+		freeRanges.erase(it->second);
+		freeBySize.erase(it);
+		if(left > 0) {
+			addFree(slot.offset + capacity, left);
+		}
+	}
+	else {
+		slot.offset = endOffset;
+		endOffset += capacity;
+	}
+	return slot;
+}
+
+void CompressedPageStore::addFree(std::uint64_t offset, std::uint64_t length)
+{
+	mergeRange(freeRanges, &freeBySize, offset, length);
+}
+
+void CompressedPageStore::truncateFree()
+{
+	if(freeRanges.empty()) {
+		return;
+	}
+	std::map<std::uint64_t, std::uint64_t>::iterator last = std::prev(freeRanges.end());
+	if(last->first + last->second != endOffset) {
+		return;
+	}
+
+	std::uint64_t end = last->first;
+	if(::ftruncate(fd, end) != 0) {
+		throw CompressedStoreException(path, "truncate");
+	}
+	std::pair<std::multimap<std::uint64_t, std::uint64_t>::iterator,
+		std::multimap<std::uint64_t, std::uint64_t>::iterator> same = freeBySize.equal_range(last->second);
+	for(std::multimap<std::uint64_t, std::uint64_t>::iterator it = same.first; it != same.second; ++it) {
+		if(it->second == last->first) {
+			freeBySize.erase(it);
+			break;
+		}
+	}
+	freeRanges.erase(last);
+	endOffset = end;
+}
+
+bool CompressedPageStore::readPage(const PageId pageNo, Page& page) const
+{
+	std::unordered_map<PageId, Slot>::const_iterator it = slots.find(pageNo);
+	if(it == slots.end()) {
+		return false;
+	}
+
+	const Slot& slot = it->second;
+	std::vector<char> buffer(slot.length);
+	if(::pread(fd, &buffer[0], slot.length, slot.offset) != (ssize_t) slot.length) {
+		throw CompressedStoreException(path, "read a page");
+	}
+
+	//a page that did not compress was stored as it is
+	if(slot.length == Page::SIZE) {
+		pageFromImage(&buffer[0], page);
+		return true;
+	}
+	std::vector<char> image(Page::SIZE);
+	if(LZ4_decompress_safe(&buffer[0], &image[0], slot.length, Page::SIZE) != (int) Page::SIZE) {
+		throw CompressedStoreException(path, "decompress a page");
+	}
+	pageFromImage(&image[0], page);
+	return true;
+}
+
+void CompressedPageStore::writePage(const Page& page)
+{
+	std::vector<char> image(Page::SIZE);
+	pageToImage(page, &image[0]);
+	std::vector<char> buffer(LZ4_compressBound(Page::SIZE));
+	int length = LZ4_compress_default(&image[0], &buffer[0], Page::SIZE, (int) buffer.size());
+	const char* data = &buffer[0];
+	if(length <= 0 || length >= (int) Page::SIZE) {
+		length = Page::SIZE;
+		data = &image[0];
+	}
+
+	std::uint32_t capacity = ((length + SLOT_GRANULE - 1) / SLOT_GRANULE) * SLOT_GRANULE;
+	Slot slot = takeSlot(capacity);
+	slot.length = length;
+	if(::pwrite(fd, data, length, slot.offset) != length) {
+		addFree(slot.offset, slot.capacity);
+		throw CompressedStoreException(path, "write a page");
+	}
+
+	erase(page.page_number());
+	slots[page.page_number()] = slot;
+	storedBytes += length;
+	unsynced.insert(page.page_number());
+}
+
+void CompressedPageStore::erase(const PageId pageNo)
+{
+	std::unordered_map<PageId, Slot>::iterator it = slots.find(pageNo);
+	if(it == slots.end()) {
+		return;
+	}
+	storedBytes -= it->second.length;
+	mergeRange(pendingFree, NULL, it->second.offset, it->second.capacity);
+	slots.erase(it);
+	unsynced.erase(pageNo);
+}
+
+/*
+ * The file is about to be removed or rebuilt, its pages must not be released afterwards.
+ */
+void CompressedPageStore::clear()
+{
+	while(!slots.empty()) {
+		erase(slots.begin()->first);
+	}
+	releasable.clear();
+	sync();
+}
+
+/*
+ * The new table is written next to the old one and renamed over it, so a crash leaves one of the two complete.
+ */
+void CompressedPageStore::sync()
+{
+	if(::fsync(fd) != 0) {
+		throw CompressedStoreException(path, "sync");
+	}
+
+	std::vector<char> table(sizeof(MapHeader) + slots.size() * sizeof(MapEntry));
+	MapHeader header = { MAGIC, 0, endOffset, slots.size() };
+	std::copy(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header + 1), table.begin());
+	std::size_t pos = sizeof(MapHeader);
+	for(std::unordered_map<PageId, Slot>::const_iterator it = slots.begin(); it != slots.end(); ++it) {
+		MapEntry entry = { it->first, it->second.length, it->second.capacity, 0, it->second.offset };
+		std::copy(reinterpret_cast<const char*>(&entry), reinterpret_cast<const char*>(&entry + 1), table.begin() + pos);
+		pos += sizeof(MapEntry);
+	}
+
+	std::string tmpPath = path + ".map.tmp";
+	int out = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(out < 0) {
+		throw CompressedStoreException(path, "write its mapping table");
+	}
+	bool ok = writeAll(out, &table[0], table.size()) && ::fsync(out) == 0;
+	::close(out);
+	if(!ok || std::rename(tmpPath.c_str(), (path + ".map").c_str()) != 0) {
+		throw CompressedStoreException(path, "write its mapping table");
+	}
+
+	//nothing durable points at these anymore
+	for(std::map<std::uint64_t, std::uint64_t>::const_iterator it = pendingFree.begin(); it != pendingFree.end(); ++it) {
+		addFree(it->first, it->second);
+	}
+	pendingFree.clear();
+	releasable.insert(unsynced.begin(), unsynced.end());
+	unsynced.clear();
+
+	//the table no longer points past the last live slot, so the end of the data file can go
+	truncateFree();
+}
+
+/*
+ * Only whole blocks inside the range are freed, the rest of it is zeroed. A file system without holes keeps
+ * the copies, that costs space and nothing else.
+ */
+void CompressedPageStore::releaseFileCopies(const File* file)
+{
+	if(releasable.empty()) {
+		return;
+	}
+	if(dynamic_cast<const PageFile*>(file) == NULL) {
+		releasable.clear();
+		return;
+	}
+
+	int out = ::open(file->filename().c_str(), O_WRONLY);
+	if(out < 0) {
+		throw CompressedStoreException(path, "open " + file->filename());
+	}
+	for(std::unordered_set<PageId>::const_iterator it = releasable.begin(); it != releasable.end(); ++it) {
+		off_t data = pageFileOffset(*it) + sizeof(PageHeader);
+		if(::fallocate(out, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, data, Page::SIZE - sizeof(PageHeader)) != 0) {
+			int error = errno;
+			::close(out);
+			if(error == EOPNOTSUPP) {
+				releasable.clear();
+				return;
+			}
+			throw CompressedStoreException(path, "release the pages of " + file->filename());
+		}
+	}
+	::close(out);
+	releasable.clear();
+}
+
+}
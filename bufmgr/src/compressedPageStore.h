@@ -0,0 +1,229 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+* @brief LZ4 compressed storage for the pages of one file, kept by the buffer manager next to the file.
+*
+* Each page is compressed on its own and written to a slot of the data file that is just large enough for it,
+* rounded up to SLOT_GRANULE bytes. A mapping table keeps the slot of every page. A page is never rewritten
+* over its live slot: a new version goes to a free slot or the end of the data file, and the old slot is only
+* reused after the next sync() made the mapping table that no longer points at it durable. A crash therefore
+* leaves every page as it was at the last sync(), and the store needs no double-write protection.
+*
+* Pages that do not compress below Page::SIZE are stored as they are. Frames in the buffer pool always hold
+* pages uncompressed; compression only happens on the way to and from the data file.
+*
+* Free space is kept in ranges: slots freed next to each other are merged into one, and a free range at the end
+* of the data file is cut off by sync().
+*
+* The store does not replace the file it belongs to. The file still allocates every page and lists the pages in
+* use, and File::allocatePage() writes each new page to it empty. releaseFileCopies() gives back the space the
+* page data takes in a PageFile once the store holds the page durably, only the page headers stay. Anything
+* reading the file directly, a pool without the store included, gets empty or old pages.
+*/
+class CompressedPageStore
+{
+ private:
+  /**
+   * Where one page lives in the data file
+   */
+  struct Slot
+  {
+    std::uint64_t offset;
+    std::uint32_t length;
+    std::uint32_t capacity;
+  };
+
+  /**
+   * Slots are sized in multiples of this many bytes
+   */
+  static const std::uint32_t SLOT_GRANULE = 512;
+
+  /**
+   * Marks a mapping table written by this class
+   */
+  static const std::uint32_t MAGIC = 0x435a5053;
+
+  /**
+   * Path of the data file, the mapping table lives next to it with ".map" appended
+   */
+  std::string path;
+
+  /**
+   * Descriptor of the data file
+   */
+  int fd;
+
+  /**
+   * Slot of every stored page
+   */
+  std::unordered_map<PageId, Slot> slots;
+
+  /**
+   * Free ranges of the data file that can be reused, by offset, with their lengths
+   */
+  std::map<std::uint64_t, std::uint64_t> freeRanges;
+
+  /**
+   * The same ranges by length, with their offsets
+   */
+  std::multimap<std::uint64_t, std::uint64_t> freeBySize;
+
+  /**
+   * Ranges given up since the last sync(), by offset, the mapping table on disk may still point at them
+   */
+  std::map<std::uint64_t, std::uint64_t> pendingFree;
+
+  /**
+   * Pages written since the last sync()
+   */
+  std::unordered_set<PageId> unsynced;
+
+  /**
+   * Pages made durable by sync() whose copies in the file were not released yet
+   */
+  std::unordered_set<PageId> releasable;
+
+  /**
+   * End of the data file
+   */
+  std::uint64_t endOffset;
+
+  /**
+   * Sum of the compressed lengths of all stored pages
+   */
+  std::uint64_t storedBytes;
+
+  /**
+   * Read the mapping table written by the last sync(), if there is one
+   */
+  void loadMap();
+
+  /**
+   * Find a free slot of at least the given capacity, or make one at the end of the data file
+   */
+  Slot takeSlot(std::uint32_t capacity);
+
+  /**
+   * Make a range free for reuse, merged with the free ranges next to it
+   */
+  void addFree(std::uint64_t offset, std::uint64_t length);
+
+  /**
+   * Cut a free range at the end of the data file off
+   *
+   * @throws CompressedStoreException If the data file cannot be truncated
+   */
+  void truncateFree();
+
+  CompressedPageStore(const CompressedPageStore&) = delete;
+  CompressedPageStore& operator=(const CompressedPageStore&) = delete;
+
+ public:
+  /**
+   * Constructor of CompressedPageStore class. Opens the data file and its mapping table, creating them if needed.
+   *
+   * @param pathIn   	Path of the data file
+   * @throws CompressedStoreException If the data file cannot be opened
+   */
+  explicit CompressedPageStore(const std::string& pathIn);
+
+  /**
+   * Destructor of CompressedPageStore class. Syncs the store.
+   */
+  ~CompressedPageStore();
+
+  /**
+   * Reads a page from the store
+   *
+   * @param pageNo   	Page number
+   * @param page   	The page is returned here if it is in the store
+   * @return  False if the page was never written to the store
+   * @throws CompressedStoreException If the page cannot be read or decompressed
+   */
+  bool readPage(const PageId pageNo, Page& page) const;
+
+  /**
+   * Compresses a page and writes it to a new slot
+   *
+   * @param page   	The page, stored under its page number
+   * @throws CompressedStoreException If the page cannot be written
+   */
+  void writePage(const Page& page);
+
+  /**
+   * Removes a page from the store. Its slot is merged with the slots given up next to it, and becomes free
+   * after the next sync().
+   *
+   * @param pageNo   	Page number
+   */
+  void erase(const PageId pageNo);
+
+  /**
+   * Removes every page from the store and syncs it, for a file that is about to be removed or rebuilt
+   *
+   * @throws CompressedStoreException If the mapping table cannot be written
+   */
+  void clear();
+
+  /**
+   * Makes everything written so far durable: syncs the data file and replaces the mapping table. Slots given up
+   * before become free, and free space at the end of the data file is cut off.
+   *
+   * @throws CompressedStoreException If the data file or the mapping table cannot be written, or the data file
+   *         cannot be truncated
+   */
+  void sync();
+
+  /**
+   * Gives back the disk space the data of the pages made durable by sync() takes in the file the store belongs
+   * to, by punching holes into it. The page headers stay, so the file still knows its pages, and the data reads
+   * back as zeros. A page not synced yet keeps its copy, a crash before sync() would leave nothing else of it.
+   * Only a PageFile is laid out in a known way, any other File keeps its copies.
+   *
+   * @param file   	File the store belongs to
+   * @throws CompressedStoreException If the file cannot be opened or a hole cannot be punched into it
+   */
+  void releaseFileCopies(const File* file);
+
+  /**
+   * Number of pages in the store
+   */
+  std::uint32_t pageCount() const
+  {
+    return (std::uint32_t) slots.size();
+  }
+
+  /**
+   * Bytes the stored pages take compressed
+   */
+  std::uint64_t compressedBytes() const
+  {
+    return storedBytes;
+  }
+
+  /**
+   * Size of the data file in bytes
+   */
+  std::uint64_t fileBytes() const
+  {
+    return endOffset;
+  }
+};
+
+}
@@ -0,0 +1,109 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include "crc32c.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BADGERDB_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+/**
+ * Reflected CRC32C polynomial
+ */
+const std::uint32_t POLY = 0x82f63b78;
+
+struct Crc32cTable
+{
+	std::uint32_t entries[256];
+
+	Crc32cTable()
+	{
+		for(std::uint32_t i = 0; i < 256; i++) {
+			std::uint32_t crc = i;
+			for(int bit = 0; bit < 8; bit++) {
+				crc = (crc & 1) ? (crc >> 1) ^ POLY : crc >> 1;
+			}
+			entries[i] = crc;
+		}
+	}
+};
+
+const Crc32cTable table;
+
+std::uint32_t crc32cSoftware(const unsigned char* data, std::size_t length, std::uint32_t crc)
+{
+	for(std::size_t i = 0; i < length; i++) {
+		crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+#ifdef BADGERDB_CRC32C_SSE42
+/*
+ * Eight bytes per instruction for the bulk of the block, then byte by byte for the tail.
+ * Compiled for SSE4.2 on its own, so the rest of the build does not need -msse4.2.
+ */
+__attribute__((target("sse4.2")))
+std::uint32_t crc32cSse42(const unsigned char* data, std::size_t length, std::uint32_t crc)
+{
+#if defined(__x86_64__)
+	std::uint64_t crc64 = crc;
+	while(length >= 8) {
+		std::uint64_t word;
+		std::memcpy(&word, data, 8);
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		length -= 8;
+	}
+	crc = (std::uint32_t) crc64;
+#endif
+	while(length >= 4) {
+		std::uint32_t word;
+		std::memcpy(&word, data, 4);
+		crc = _mm_crc32_u32(crc, word);
+		data += 4;
+		length -= 4;
+	}
+	while(length > 0) {
+		crc = _mm_crc32_u8(crc, *data);
+		data++;
+		length--;
+	}
+	return crc;
+}
+
+const bool hasSse42 = __builtin_cpu_supports("sse4.2");
+#else
+const bool hasSse42 = false;
+#endif
+
+}
+
+std::uint32_t crc32c(const void* data, std::size_t length, std::uint32_t crc)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	crc = ~crc;
+#ifdef BADGERDB_CRC32C_SSE42
+	if(hasSse42) {
+		return ~crc32cSse42(bytes, length, crc);
+	}
+#endif
+	return ~crc32cSoftware(bytes, length, crc);
+}
+
+bool crc32cHardware()
+{
+	return hasSse42;
+}
+
+}
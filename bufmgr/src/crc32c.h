@@ -0,0 +1,31 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace badgerdb {
+
+/**
+ * CRC32C (Castagnoli) of a block of memory. Uses the SSE4.2 crc32 instruction when the CPU has it and a
+ * table driven software version otherwise; both give the same result.
+ *
+ * @param data   	Start of the block
+ * @param length   	Length of the block in bytes
+ * @param crc   	CRC of the data before this block, to checksum a sequence of blocks in pieces
+ * @return  CRC of everything so far
+ */
+std::uint32_t crc32c(const void* data, std::size_t length, std::uint32_t crc = 0);
+
+/**
+ * True if crc32c() runs on the SSE4.2 crc32 instruction
+ */
+bool crc32cHardware();
+
+}
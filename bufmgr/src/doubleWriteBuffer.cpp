@@ -0,0 +1,339 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include <set>
+#include <fcntl.h>
+#include <unistd.h>
+#include "doubleWriteBuffer.h"
+#include "crc32c.h"
+#include "pageImage.h"
+#include "exceptions/double_write_exception.h"
+
+namespace badgerdb {
+
+DoubleWriteBuffer::DoubleWriteBuffer(const std::string& pathIn, std::uint32_t capacityIn)
+	: path(pathIn), capacity(capacityIn == 0 ? 1 : capacityIn), sequence(1)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		throw DoubleWriteException(path, "open");
+	}
+	pages.reserve(capacity);
+	files.reserve(capacity);
+}
+
+DoubleWriteBuffer::~DoubleWriteBuffer()
+{
+	::close(fd);
+}
+
+void DoubleWriteBuffer::sealSlot(SlotHeader& header, const char* image)
+{
+	header.magic = MAGIC;
+	header.crc = 0;
+	std::uint32_t crc = crc32c(&header, sizeof(SlotHeader));
+	header.crc = crc32c(image, Page::SIZE, crc);
+}
+
+void DoubleWriteBuffer::syncFile(const std::string& filename, const std::string& area)
+{
+	int fileFd = ::open(filename.c_str(), O_RDONLY);
+	if(fileFd < 0) {
+		throw DoubleWriteException(area, "open " + filename + " to sync it");
+	}
+	int result = ::fsync(fileFd);
+	::close(fileFd);
+	if(result != 0) {
+		throw DoubleWriteException(area, "sync " + filename);
+	}
+}
+
+void DoubleWriteBuffer::add(File* file, const Page& page)
+{
+	std::map<std::pair<const File*, PageId>, std::size_t>::iterator it = index.find(std::make_pair(file, page.page_number()));
+	if(it != index.end()) {
+		pages[it->second] = page;
+		return;
+	}
+
+	index[std::make_pair(file, page.page_number())] = pages.size();
+	files.push_back(file);
+	pages.push_back(page);
+}
+
+/*
+ * The batch is newer than the flush under way, so it is looked at first.
+ */
+bool DoubleWriteBuffer::find(const File* file, const PageId pageNo, Page& page) const
+{
+	std::map<std::pair<const File*, PageId>, std::size_t>::const_iterator it = index.find(std::make_pair(file, pageNo));
+	if(it != index.end()) {
+		page = pages[it->second];
+		return true;
+	}
+	it = flushingIndex.find(std::make_pair(file, pageNo));
+	if(it != flushingIndex.end()) {
+		page = flushingPages[it->second];
+		return true;
+	}
+	return false;
+}
+
+/*
+ * The last page of the batch takes the place of the removed one.
+ */
+void DoubleWriteBuffer::removeAt(std::size_t pos)
+{
+	index.erase(std::make_pair((const File*) files[pos], pages[pos].page_number()));
+	if(pos != pages.size() - 1) {
+		files[pos] = files.back();
+		pages[pos] = pages.back();
+		index[std::make_pair((const File*) files[pos], pages[pos].page_number())] = pos;
+	}
+	files.pop_back();
+	pages.pop_back();
+}
+
+void DoubleWriteBuffer::drop(const File* file, const PageId pageNo)
+{
+	std::map<std::pair<const File*, PageId>, std::size_t>::iterator it = index.find(std::make_pair(file, pageNo));
+	if(it != index.end()) {
+		removeAt(it->second);
+	}
+}
+
+void DoubleWriteBuffer::dropFile(const File* file)
+{
+	for(std::size_t i = pages.size(); i > 0; i--) {
+		if(files[i - 1] == file) {
+			removeAt(i - 1);
+		}
+	}
+}
+
+/*
+ * One sequential write and one fsync for the whole batch, then the writes in place and an fsync of each
+ * file they went to. Only once those are done does a slot with a newer sequence number and no pages tell
+ * recover() there is nothing left to replay, so pages deleted later are not brought back.
+ */
+std::uint32_t DoubleWriteBuffer::flush()
+{
+	if(pages.empty()) {
+		return 0;
+	}
+
+	std::uint32_t count = beginFlush();
+	try {
+		writeArea();
+		for(std::uint32_t i = 0; i < count; i++) {
+			writeInPlace(i);
+		}
+		syncFiles();
+		writeMarker();
+	} catch(...) {
+		cancelFlush();
+		throw;
+	}
+	endFlush();
+	return count;
+}
+
+/*
+ * Each file name goes after the slots once, however many of its pages the batch holds.
+ */
+std::uint32_t DoubleWriteBuffer::beginFlush()
+{
+	flushingFiles.swap(files);
+	flushingPages.swap(pages);
+	flushingIndex.swap(index);
+	files.clear();
+	pages.clear();
+	index.clear();
+
+	std::uint32_t count = (std::uint32_t) flushingPages.size();
+	area.assign(SLOT_SIZE * count, 0);
+	std::map<std::string, std::uint64_t> names;
+	for(std::uint32_t i = 0; i < count; i++) {
+		const std::string& name = flushingFiles[i]->filename();
+		std::map<std::string, std::uint64_t>::iterator it = names.find(name);
+		if(it == names.end()) {
+			it = names.insert(std::make_pair(name, (std::uint64_t) area.size())).first;
+			area.insert(area.end(), name.begin(), name.end());
+		}
+
+		char* slot = &area[SLOT_SIZE * i];
+		SlotHeader header;
+		std::memset(&header, 0, sizeof(SlotHeader));
+		header.sequence = sequence;
+		header.count = count;
+		header.pageNo = flushingPages[i].page_number();
+		header.nameOffset = it->second;
+		header.nameLength = (std::uint32_t) name.size();
+		header.nameCrc = crc32c(name.data(), name.size());
+
+		pageToImage(flushingPages[i], slot + sizeof(SlotHeader));
+		sealSlot(header, slot + sizeof(SlotHeader));
+		std::memcpy(slot, &header, sizeof(SlotHeader));
+	}
+	return count;
+}
+
+void DoubleWriteBuffer::writeArea()
+{
+	std::size_t written = 0;
+	while(written < area.size()) {
+		ssize_t n = ::pwrite(fd, &area[written], area.size() - written, written);
+		if(n <= 0) {
+			throw DoubleWriteException(path, "write");
+		}
+		written += n;
+	}
+	if(::fsync(fd) != 0) {
+		throw DoubleWriteException(path, "sync");
+	}
+}
+
+void DoubleWriteBuffer::writeInPlace(std::uint32_t pos)
+{
+	flushingFiles[pos]->writePage(flushingPages[pos]);
+}
+
+void DoubleWriteBuffer::syncFiles()
+{
+	std::set<std::string> synced;
+	for(std::size_t i = 0; i < flushingFiles.size(); i++) {
+		synced.insert(flushingFiles[i]->filename());
+	}
+	for(std::set<std::string>::iterator it = synced.begin(); it != synced.end(); ++it) {
+		syncFile(*it, path);
+	}
+}
+
+/*
+ * The marker goes over the first slot, whose copy is not needed any more once the files are synced, and is
+ * synced as well, since a lost marker would let recover() write back a page deleted after the flush.
+ */
+void DoubleWriteBuffer::writeMarker()
+{
+	std::vector<char> done(SLOT_SIZE, 0);
+	SlotHeader header;
+	std::memset(&header, 0, sizeof(SlotHeader));
+	header.sequence = sequence + 1;
+	header.count = 0;
+	sealSlot(header, &done[sizeof(SlotHeader)]);
+	std::memcpy(&done[0], &header, sizeof(SlotHeader));
+	if(::pwrite(fd, &done[0], SLOT_SIZE, 0) != (ssize_t) SLOT_SIZE) {
+		throw DoubleWriteException(path, "write");
+	}
+	if(::fsync(fd) != 0) {
+		throw DoubleWriteException(path, "sync");
+	}
+}
+
+void DoubleWriteBuffer::endFlush()
+{
+	sequence += 2;
+	flushingFiles.clear();
+	flushingPages.clear();
+	flushingIndex.clear();
+	area.clear();
+}
+
+/*
+ * The area may hold part of the failed flush, the next one gets a newer sequence number all the same.
+ */
+void DoubleWriteBuffer::cancelFlush()
+{
+	for(std::size_t i = 0; i < flushingPages.size(); i++) {
+		if(index.count(std::make_pair((const File*) flushingFiles[i], flushingPages[i].page_number())) == 0) {
+			add(flushingFiles[i], flushingPages[i]);
+		}
+	}
+	endFlush();
+}
+
+std::uint32_t DoubleWriteBuffer::recover(const std::string& path, const std::vector<File*>& files)
+{
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		return 0;
+	}
+
+	//every slot that is intact, and the newest batch among them
+	std::vector<std::vector<char> > slots;
+	std::uint64_t newest = 0;
+	std::vector<char> slot(SLOT_SIZE);
+	for(off_t offset = 0; ::pread(fd, &slot[0], SLOT_SIZE, offset) == (ssize_t) SLOT_SIZE; offset += SLOT_SIZE) {
+		//sealing the header again has to give back exactly what was read, magic and CRC included
+		SlotHeader header;
+		std::memcpy(&header, &slot[0], sizeof(SlotHeader));
+		sealSlot(header, &slot[sizeof(SlotHeader)]);
+		if(std::memcmp(&slot[0], &header, sizeof(SlotHeader)) != 0) {
+			continue;
+		}
+		slots.push_back(slot);
+		if(header.sequence > newest) {
+			newest = header.sequence;
+		}
+	}
+
+	std::vector<std::vector<char> > batch;
+	std::uint32_t count = 0;
+	for(std::size_t i = 0; i < slots.size(); i++) {
+		SlotHeader header;
+		std::memcpy(&header, &slots[i][0], sizeof(SlotHeader));
+		if(header.sequence == newest) {
+			batch.push_back(slots[i]);
+			count = header.count;
+		}
+	}
+
+	//a batch that did not reach the area completely was never written in place either
+	if(count == 0 || batch.size() != count) {
+		::close(fd);
+		return 0;
+	}
+
+	//the names were written along with the slots, a name that does not match its CRC means they were not
+	std::vector<std::string> names(batch.size());
+	for(std::size_t i = 0; i < batch.size(); i++) {
+		SlotHeader header;
+		std::memcpy(&header, &batch[i][0], sizeof(SlotHeader));
+		names[i].resize(header.nameLength);
+		if(header.nameLength > 0 && ::pread(fd, &names[i][0], header.nameLength, header.nameOffset) != (ssize_t) header.nameLength) {
+			::close(fd);
+			return 0;
+		}
+		if(crc32c(names[i].data(), names[i].size()) != header.nameCrc) {
+			::close(fd);
+			return 0;
+		}
+	}
+	::close(fd);
+
+	std::uint32_t restored = 0;
+	std::set<std::string> synced;
+	for(std::size_t i = 0; i < batch.size(); i++) {
+		for(std::size_t f = 0; f < files.size(); f++) {
+			if(files[f]->filename() == names[i]) {
+				Page page;
+				pageFromImage(&batch[i][sizeof(SlotHeader)], page);
+				files[f]->writePage(page);
+				synced.insert(files[f]->filename());
+				restored++;
+				break;
+			}
+		}
+	}
+	for(std::set<std::string>::iterator it = synced.begin(); it != synced.end(); ++it) {
+		syncFile(*it, path);
+	}
+	return restored;
+}
+
+}
@@ -0,0 +1,306 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+* @brief Protects page write-back against torn pages, in the style of InnoDB's doublewrite buffer.
+*
+* Pages written back are collected in a batch. When the batch is flushed, all of its pages are first written one
+* after another to a separate double-write area and synced with a single fsync, and only then written in place in
+* their files. A crash while the pages are written in place can tear them, but leaves a complete copy of each in
+* the double-write area, and recover() puts those copies back. A crash while the double-write area is written
+* leaves the pages in place untouched. The files are synced once the pages are in place, and only then is the
+* area marked as done, so the copies are given up only when they are no longer needed.
+*
+* Every slot of the area carries the batch sequence number, the number of pages in the batch and a CRC32C over
+* header and page, so recover() only replays a batch that reached the area completely. The names of the files follow
+* the slots, each once and at full length, and a slot points at the name of its file and carries its CRC32C.
+*
+* A flush can be run in steps, so its owner only has to hold its own locks while the batch changes hands:
+* beginFlush() moves the batch aside and builds the area image, writeArea(), writeInPlace() for each page,
+* syncFiles() and writeMarker() do the I/O, and endFlush() or cancelFlush() finish it. Pages moved aside are still
+* found by find() until then, and new pages go into a new batch meanwhile. Only one flush can be under way.
+*/
+class DoubleWriteBuffer
+{
+ private:
+  /**
+   * Header in front of every page in the double-write area
+   */
+  struct SlotHeader
+  {
+    std::uint32_t magic;
+    std::uint32_t crc;
+    std::uint64_t sequence;
+    std::uint32_t count;
+    std::uint32_t pageNo;
+    std::uint64_t nameOffset;
+    std::uint32_t nameLength;
+    std::uint32_t nameCrc;
+  };
+
+  /**
+   * Marks a slot written by this class
+   */
+  static const std::uint32_t MAGIC = 0x44574246;
+
+  /**
+   * Size of one slot in the double-write area
+   */
+  static const std::size_t SLOT_SIZE = sizeof(SlotHeader) + Page::SIZE;
+
+  /**
+   * Path of the double-write area
+   */
+  std::string path;
+
+  /**
+   * Descriptor of the double-write area
+   */
+  int fd;
+
+  /**
+   * Number of pages a batch holds
+   */
+  std::uint32_t capacity;
+
+  /**
+   * Sequence number of the next batch
+   */
+  std::uint64_t sequence;
+
+  /**
+   * Files of the pages in the batch
+   */
+  std::vector<File*> files;
+
+  /**
+   * Pages in the batch
+   */
+  std::vector<Page> pages;
+
+  /**
+   * Position of each page of the batch in files and pages
+   */
+  std::map<std::pair<const File*, PageId>, std::size_t> index;
+
+  /**
+   * Files of the pages of the flush under way
+   */
+  std::vector<File*> flushingFiles;
+
+  /**
+   * Pages of the flush under way
+   */
+  std::vector<Page> flushingPages;
+
+  /**
+   * Position of each page of the flush under way in flushingFiles and flushingPages
+   */
+  std::map<std::pair<const File*, PageId>, std::size_t> flushingIndex;
+
+  /**
+   * Image of the double-write area for the flush under way, slots followed by file names
+   */
+  std::vector<char> area;
+
+  /**
+   * Remove the page at the given position from the batch
+   */
+  void removeAt(std::size_t pos);
+
+  /**
+   * Flush what was written to a file to stable storage. File has no call for it, so the file is opened
+   * again by name and synced through that descriptor, which syncs the file and not just the descriptor.
+   *
+   * @param filename   	Name of the file
+   * @param area   	Path of the double-write area, for the exception
+   * @throws DoubleWriteException If the file cannot be opened or synced
+   */
+  static void syncFile(const std::string& filename, const std::string& area);
+
+  /**
+   * Fill in a slot header and its CRC
+   */
+  static void sealSlot(SlotHeader& header, const char* image);
+
+  DoubleWriteBuffer(const DoubleWriteBuffer&) = delete;
+  DoubleWriteBuffer& operator=(const DoubleWriteBuffer&) = delete;
+
+ public:
+  /**
+   * Constructor of DoubleWriteBuffer class. Creates the double-write area, or empties it if it exists,
+   * so recover() has to run on it before.
+   *
+   * @param pathIn   	Path of the double-write area
+   * @param capacityIn   	Number of pages written together
+   * @throws DoubleWriteException If the area cannot be created
+   */
+  DoubleWriteBuffer(const std::string& pathIn, std::uint32_t capacityIn);
+
+  /**
+   * Destructor of DoubleWriteBuffer class. Pages still in the batch are not written, the owner flushes first.
+   */
+  ~DoubleWriteBuffer();
+
+  /**
+   * Adds a page to the batch, replacing an earlier version of the same page that is still in it
+   *
+   * @param file   	File the page belongs to
+   * @param page   	The page
+   */
+  void add(File* file, const Page& page);
+
+  /**
+   * True if the batch holds as many pages as it can
+   */
+  bool full() const
+  {
+    return pages.size() >= capacity;
+  }
+
+  /**
+   * Number of pages in the batch
+   */
+  std::uint32_t size() const
+  {
+    return (std::uint32_t) pages.size();
+  }
+
+  /**
+   * Looks for a page in the batch and in the flush under way. Such a page is newer than the copy in its file.
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   * @param page   	The page is copied here if it is in the batch
+   * @return  True if the page is in the batch
+   */
+  bool find(const File* file, const PageId pageNo, Page& page) const;
+
+  /**
+   * Forgets a page of the batch, used when the page is deleted from its file. A page in the flush under way
+   * is still written, the flush has to be over before the page is deleted.
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   */
+  void drop(const File* file, const PageId pageNo);
+
+  /**
+   * Forgets all pages of a file in the batch. Like drop(), leaves the flush under way alone.
+   *
+   * @param file   	File object
+   */
+  void dropFile(const File* file);
+
+  /**
+   * Writes the batch to the double-write area, syncs it, then writes each page in place, syncs the files the
+   * pages belong to, marks the area as done and empties the batch. The steps below, one after the other.
+   *
+   * @return  Number of pages written
+   * @throws DoubleWriteException If the double-write area or one of the files cannot be written or synced
+   */
+  std::uint32_t flush();
+
+  /**
+   * Moves the batch aside for a flush and builds what goes to the double-write area. The batch starts over empty.
+   *
+   * @return  Number of pages in the flush
+   */
+  std::uint32_t beginFlush();
+
+  /**
+   * True while a flush is under way, between beginFlush() and endFlush() or cancelFlush()
+   */
+  bool flushing() const
+  {
+    return !flushingPages.empty();
+  }
+
+  /**
+   * True if the page is part of the flush under way
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   */
+  bool inFlight(const File* file, const PageId pageNo) const
+  {
+    return flushingIndex.count(std::make_pair(file, pageNo)) != 0;
+  }
+
+  /**
+   * Writes the pages of the flush to the double-write area in one write and syncs it
+   *
+   * @throws DoubleWriteException If the area cannot be written or synced
+   */
+  void writeArea();
+
+  /**
+   * File of a page of the flush
+   *
+   * @param pos   	Position of the page in the flush, below the number beginFlush() returned
+   */
+  File* flushingFile(std::uint32_t pos) const
+  {
+    return flushingFiles[pos];
+  }
+
+  /**
+   * Writes a page of the flush in place in its file
+   *
+   * @param pos   	Position of the page in the flush, below the number beginFlush() returned
+   */
+  void writeInPlace(std::uint32_t pos);
+
+  /**
+   * Syncs every file a page of the flush was written to
+   *
+   * @throws DoubleWriteException If one of the files cannot be synced
+   */
+  void syncFiles();
+
+  /**
+   * Marks the double-write area as done, so recover() does not replay the flush, and syncs it
+   *
+   * @throws DoubleWriteException If the area cannot be written or synced
+   */
+  void writeMarker();
+
+  /**
+   * Forgets the pages of a flush that went through
+   */
+  void endFlush();
+
+  /**
+   * Gives up on a flush that failed. Its pages go back into the batch, unless a newer version of a page is in it
+   * already, so the next flush writes them again.
+   */
+  void cancelFlush();
+
+  /**
+   * Writes the pages of the last complete batch in a double-write area back in place and syncs their files.
+   * Run at startup, before a DoubleWriteBuffer is created on the same path. Pages of files that are not given
+   * are skipped. Writing the pages again is harmless, so recover() may be run again after a crash during it.
+   *
+   * @param path   	Path of the double-write area
+   * @param files   	Open files the pages may belong to
+   * @return  Number of pages written back
+   * @throws DoubleWriteException If one of the files cannot be synced
+   */
+  static std::uint32_t recover(const std::string& path, const std::vector<File*>& files);
+};
+
+}
@@ -0,0 +1,41 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a bulk load cannot read or write the file it is loading.
+ */
+class BulkLoadException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a bulk load exception.
+   *
+   * @param pathIn  Path of the file being loaded.
+   * @param operationIn  What was being done when it failed.
+   */
+  BulkLoadException(const std::string& pathIn, const std::string& operationIn);
+
+ protected:
+  /**
+   * Path of the file being loaded.
+   */
+  const std::string path;
+
+  /**
+   * What was being done when it failed.
+   */
+  const std::string operation;
+};
+
+}
@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "checksum_file_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+ChecksumFileException::ChecksumFileException(const std::string& pathIn, const std::string& operationIn)
+    : BadgerDbException(""), path(pathIn), operation(operationIn) {
+  std::stringstream ss;
+  ss << "Checksum file " << path << " failed to " << operation;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when the checksum file next to a data file cannot be opened, read or written.
+ */
+class ChecksumFileException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a checksum file exception.
+   *
+   * @param pathIn  Path of the checksum file.
+   * @param operationIn  What was being done when it failed.
+   */
+  ChecksumFileException(const std::string& pathIn, const std::string& operationIn);
+
+ protected:
+  /**
+   * Path of the checksum file.
+   */
+  const std::string path;
+
+  /**
+   * What was being done when it failed.
+   */
+  const std::string operation;
+};
+
+}
@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a compressed page store cannot read or write its files.
+ */
+class CompressedStoreException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a compressed store exception.
+   *
+   * @param pathIn  Path of the store's data file.
+   * @param operationIn  What was being done when it failed.
+   */
+  CompressedStoreException(const std::string& pathIn, const std::string& operationIn);
+
+ protected:
+  /**
+   * Path of the store's data file.
+   */
+  const std::string path;
+
+  /**
+   * What was being done when it failed.
+   */
+  const std::string operation;
+};
+
+}
@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "double_write_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+DoubleWriteException::DoubleWriteException(const std::string& pathIn, const std::string& operationIn)
+    : BadgerDbException(""), path(pathIn), operation(operationIn) {
+  std::stringstream ss;
+  ss << "Double-write area " << path << " failed to " << operation;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when the double-write area cannot be opened, written or synced.
+ */
+class DoubleWriteException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a double write exception.
+   *
+   * @param pathIn  Path of the double-write area.
+   * @param operationIn  What was being done when it failed.
+   */
+  DoubleWriteException(const std::string& pathIn, const std::string& operationIn);
+
+ protected:
+  /**
+   * Path of the double-write area.
+   */
+  const std::string path;
+
+  /**
+   * What was being done when it failed.
+   */
+  const std::string operation;
+};
+
+}
@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "flash_cache_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+FlashCacheException::FlashCacheException(const std::string& pathIn, const std::string& operationIn)
+    : BadgerDbException(""), path(pathIn), operation(operationIn) {
+  std::stringstream ss;
+  ss << "Flash cache file " << path << " failed to " << operation;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,42 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when the flash cache file cannot be opened, read or written.
+ */
+class FlashCacheException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a flash cache exception.
+   *
+   * @param pathIn  Path of the cache file.
+   * @param operationIn  What was being done when it failed.
+   */
+  FlashCacheException(const std::string& pathIn, const std::string& operationIn);
+
+ protected:
+  /**
+   * Path of the cache file.
+   */
+  const std::string path;
+
+  /**
+   * What was being done when it failed.
+   */
+  const std::string operation;
+};
+
+}
@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "grant_pinned_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+GrantPinnedException::GrantPinnedException(const std::uint32_t pinnedIn)
+    : BadgerDbException(""), pinned(pinnedIn) {
+  std::stringstream ss;
+  ss << "Frame reservation released with " << pinned << " frames still pinned";
+  message_.assign(ss.str());
+}
+
+}
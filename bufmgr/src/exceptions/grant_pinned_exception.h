@@ -0,0 +1,37 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a frame reservation is released while frames charged to it are still pinned.
+ */
+class GrantPinnedException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a grant pinned exception.
+   *
+   * @param pinnedIn  Number of frames still pinned under the reservation.
+   */
+  explicit GrantPinnedException(const std::uint32_t pinnedIn);
+
+ protected:
+  /**
+   * Number of frames still pinned under the reservation.
+   */
+  const std::uint32_t pinned;
+};
+
+}
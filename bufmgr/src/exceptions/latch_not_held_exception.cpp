@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "latch_not_held_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+LatchNotHeldException::LatchNotHeldException(const std::string& nameIn, const PageId pageNoIn, const int modeIn)
+    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), mode(modeIn) {
+  std::stringstream ss;
+  ss << "Page " << pageNo << " of file " << name << " is not latched in mode " << mode;
+  message_.assign(ss.str());
+}
+
+}
@@ -0,0 +1,48 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page is released in a latch mode it is not latched in.
+ */
+class LatchNotHeldException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a latch not held exception for the given page.
+   *
+   * @param nameIn    Name of the file the page belongs to.
+   * @param pageNoIn  Number of the page.
+   * @param modeIn    Latch mode the caller tried to release.
+   */
+  LatchNotHeldException(const std::string& nameIn, const PageId pageNoIn, const int modeIn);
+
+ protected:
+  /**
+   * Name of the file the page belongs to.
+   */
+  const std::string name;
+
+  /**
+   * Number of the page.
+   */
+  const PageId pageNo;
+
+  /**
+   * Latch mode the caller tried to release.
+   */
+  const int mode;
+};
+
+}
@@ -0,0 +1,22 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "mapped_file_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+MappedFileException::MappedFileException(const std::string& pathIn, const std::string& operationIn)
+    : BadgerDbException(""), path(pathIn), operation(operationIn) {
+  std::stringstream ss;
+  ss << "Mapped file " << path << " failed to " << operation;
+  message_.assign(ss.str());
+}
+
+}
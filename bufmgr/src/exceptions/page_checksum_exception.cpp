@@ -0,0 +1,24 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "page_checksum_exception.h"
+
+#include <sstream>
+#include <string>
+
+namespace badgerdb {
+
+PageChecksumException::PageChecksumException(const std::string& nameIn, const PageId pageNoIn,
+                                             const std::uint32_t expectedIn, const std::uint32_t actualIn)
+    : BadgerDbException(""), name(nameIn), pageNo(pageNoIn), expected(expectedIn), actual(actualIn) {
+  std::stringstream ss;
+  ss << "Checksum mismatch on page " << pageNo << " of file " << name
+     << ": written with " << std::hex << expected << ", read as " << actual;
+  message_.assign(ss.str());
+}
+
+}
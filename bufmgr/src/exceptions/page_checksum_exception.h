@@ -0,0 +1,56 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when a page read from disk does not match the checksum it was written with.
+ */
+class PageChecksumException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a page checksum exception for the given page.
+   *
+   * @param nameIn  Name of the file the page was read from.
+   * @param pageNoIn  Page number of the page.
+   * @param expectedIn  Checksum the page was written with.
+   * @param actualIn  Checksum of the page as it was read.
+   */
+  PageChecksumException(const std::string& nameIn, const PageId pageNoIn,
+                        const std::uint32_t expectedIn, const std::uint32_t actualIn);
+
+ protected:
+  /**
+   * Name of the file the page was read from.
+   */
+  const std::string name;
+
+  /**
+   * Page number of the page.
+   */
+  const PageId pageNo;
+
+  /**
+   * Checksum the page was written with.
+   */
+  const std::uint32_t expected;
+
+  /**
+   * Checksum of the page as it was read.
+   */
+  const std::uint32_t actual;
+};
+
+}
@@ -0,0 +1,36 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "badgerdb_exception.h"
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+ * @brief An exception that is thrown when creating a buffer pool whose name is already taken.
+ */
+class PoolExistsException : public BadgerDbException {
+ public:
+  /**
+   * Constructs a pool exists exception.
+   *
+   * @param nameIn  Name of the buffer pool.
+   */
+  explicit PoolExistsException(const std::string& nameIn);
+
+ protected:
+  /**
+   * Name of the buffer pool.
+   */
+  const std::string name;
+};
+
+}
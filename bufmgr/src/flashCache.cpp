@@ -0,0 +1,119 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include "flashCache.h"
+#include "pageImage.h"
+#include "exceptions/flash_cache_exception.h"
+
+namespace badgerdb {
+
+FlashCache::FlashCache(const std::string& pathIn, std::uint32_t capacityIn)
+	: path(pathIn), capacity(capacityIn == 0 ? 1 : capacityIn), hand(0)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if(fd < 0) {
+		throw FlashCacheException(path, "open");
+	}
+
+	SlotInfo empty;
+	empty.key.file = NULL;
+	empty.key.pageNo = Page::INVALID_NUMBER;
+	empty.used = false;
+	empty.refbit = false;
+	slots.assign(capacity, empty);
+}
+
+FlashCache::~FlashCache()
+{
+	::close(fd);
+}
+
+/*
+ * Same clock as the buffer pool's: free slots are taken right away, used ones lose their refbit first.
+ */
+std::uint32_t FlashCache::victim()
+{
+	for(;;) {
+		std::uint32_t slot = hand;
+		hand = (hand + 1) % capacity;
+
+		if(!slots[slot].used) {
+			return slot;
+		}
+		if(slots[slot].refbit) {
+			slots[slot].refbit = false;
+			continue;
+		}
+		index.erase(slots[slot].key);
+		slots[slot].used = false;
+		return slot;
+	}
+}
+
+void FlashCache::admit(const File* file, const Page& page)
+{
+	PageKey key = { file, page.page_number() };
+	//writing a page back erases it from the cache, so a copy still here is the same page
+	if(index.find(key) != index.end()) {
+		return;
+	}
+	std::uint32_t slot = victim();
+
+	std::vector<char> image(Page::SIZE);
+	pageToImage(page, &image[0]);
+	if(::pwrite(fd, &image[0], Page::SIZE, (off_t) slot * Page::SIZE) != (ssize_t) Page::SIZE) {
+		//the slot may hold half of the page now
+		slots[slot].used = false;
+		throw FlashCacheException(path, "write a page");
+	}
+
+	slots[slot].key = key;
+	slots[slot].used = true;
+	slots[slot].refbit = false;
+	index[key] = slot;
+}
+
+bool FlashCache::lookup(const File* file, const PageId pageNo, Page& page)
+{
+	PageKey key = { file, pageNo };
+	std::unordered_map<PageKey, std::uint32_t, PageKeyHash>::iterator it = index.find(key);
+	if(it == index.end()) {
+		return false;
+	}
+
+	std::vector<char> image(Page::SIZE);
+	if(::pread(fd, &image[0], Page::SIZE, (off_t) it->second * Page::SIZE) != (ssize_t) Page::SIZE) {
+		throw FlashCacheException(path, "read a page");
+	}
+	pageFromImage(&image[0], page);
+	slots[it->second].refbit = true;
+	return true;
+}
+
+void FlashCache::erase(const File* file, const PageId pageNo)
+{
+	PageKey key = { file, pageNo };
+	std::unordered_map<PageKey, std::uint32_t, PageKeyHash>::iterator it = index.find(key);
+	if(it != index.end()) {
+		slots[it->second].used = false;
+		index.erase(it);
+	}
+}
+
+void FlashCache::eraseFile(const File* file)
+{
+	for(std::uint32_t i = 0; i < capacity; i++) {
+		if(slots[i].used && slots[i].key.file == file) {
+			index.erase(slots[i].key);
+			slots[i].used = false;
+		}
+	}
+}
+
+}
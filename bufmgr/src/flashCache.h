@@ -0,0 +1,138 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "file.h"
+#include "pageKey.h"
+
+namespace badgerdb {
+
+/**
+* @brief Cache of pages in a file on a fast local device, such as an SSD, in front of files on slow storage.
+*
+* The cache file is an array of Page::SIZE slots. Pages evicted from the buffer pool are admitted into a slot and
+* misses look for them there before going to their own file. Slots are replaced with a clock of their own, which
+* gives a second chance to pages that were read from the cache since the hand last passed. The index lives in
+* memory only, so the cache starts out empty every time it is created.
+*/
+class FlashCache
+{
+ private:
+  /**
+   * What a slot of the cache file holds
+   */
+  struct SlotInfo
+  {
+    PageKey key;
+    bool used;
+    bool refbit;
+  };
+
+  /**
+   * Path of the cache file
+   */
+  std::string path;
+
+  /**
+   * Descriptor of the cache file
+   */
+  int fd;
+
+  /**
+   * Number of slots in the cache file
+   */
+  std::uint32_t capacity;
+
+  /**
+   * What each slot holds
+   */
+  std::vector<SlotInfo> slots;
+
+  /**
+   * Slot of every cached page
+   */
+  std::unordered_map<PageKey, std::uint32_t, PageKeyHash> index;
+
+  /**
+   * Slot the clock looks at next
+   */
+  std::uint32_t hand;
+
+  /**
+   * Find a slot for a new page, dropping the page in it if there is one
+   */
+  std::uint32_t victim();
+
+  FlashCache(const FlashCache&) = delete;
+  FlashCache& operator=(const FlashCache&) = delete;
+
+ public:
+  /**
+   * Constructor of FlashCache class. Creates the cache file, or empties it if it exists.
+   *
+   * @param pathIn   	Path of the cache file, on the fast device
+   * @param capacityIn   	Number of pages the cache holds
+   * @throws FlashCacheException If the cache file cannot be created
+   */
+  FlashCache(const std::string& pathIn, std::uint32_t capacityIn);
+
+  /**
+   * Destructor of FlashCache class. Closes the cache file and leaves it behind.
+   */
+  ~FlashCache();
+
+  /**
+   * Writes a page into the cache. A page that is in the cache already is left as it is, without a write; the
+   * caller erases the cached copy of a page whenever it writes the page back to its file.
+   *
+   * @param file   	File the page belongs to
+   * @param page   	The page, as it is in its file
+   * @throws FlashCacheException If the cache file cannot be written
+   */
+  void admit(const File* file, const Page& page);
+
+  /**
+   * Reads a page from the cache
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   * @param page   	The page is read into here if it is in the cache
+   * @return  True if the page was in the cache
+   * @throws FlashCacheException If the cache file cannot be read
+   */
+  bool lookup(const File* file, const PageId pageNo, Page& page);
+
+  /**
+   * Drops a page from the cache, used when the copy in its file changes or goes away
+   *
+   * @param file   	File the page belongs to
+   * @param pageNo   	Page number in the file
+   */
+  void erase(const File* file, const PageId pageNo);
+
+  /**
+   * Drops every page of a file from the cache
+   *
+   * @param file   	File object
+   */
+  void eraseFile(const File* file);
+
+  /**
+   * Number of pages in the cache
+   */
+  std::uint32_t size() const
+  {
+    return (std::uint32_t) index.size();
+  }
+};
+
+}
@@ -0,0 +1,153 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "frameBitmap.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define BADGERDB_FRAME_BITMAP_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace badgerdb {
+
+namespace {
+
+const std::uint32_t BLOCK_WORDS = FrameBitmap::BLOCK_FRAMES / 64;
+
+#ifdef BADGERDB_FRAME_BITMAP_AVX2
+/*
+ * Tests a whole block for a frame that is invalid, or unpinned and unreferenced. If there is none, all
+ * refbits of the block are cleared, as the clock passes all of it. Compiled for AVX2 on its own, so the
+ * rest of the build does not need -mavx2.
+ */
+__attribute__((target("avx2")))
+bool blockPassedAvx2(const std::uint64_t* valid, std::uint64_t* referenced, const std::uint64_t* pinned)
+{
+	__m256i ones = _mm256_set1_epi64x(-1);
+	__m256i v = _mm256_loadu_si256((const __m256i*) valid);
+	__m256i r = _mm256_loadu_si256((const __m256i*) referenced);
+	__m256i p = _mm256_loadu_si256((const __m256i*) pinned);
+
+	//~valid | (~referenced & ~pinned)
+	__m256i takeable = _mm256_or_si256(_mm256_andnot_si256(v, ones), _mm256_andnot_si256(r, _mm256_andnot_si256(p, ones)));
+	if(!_mm256_testz_si256(takeable, takeable)) {
+		return false;
+	}
+	_mm256_storeu_si256((__m256i*) referenced, _mm256_setzero_si256());
+	return true;
+}
+
+const bool hasAvx2 = __builtin_cpu_supports("avx2");
+#else
+const bool hasAvx2 = false;
+#endif
+
+}
+
+FrameBitmap::FrameBitmap(std::uint32_t numFramesIn)
+	: numFrames(numFramesIn), hand(numFramesIn - 1)
+{
+	std::uint32_t words = (numFrames + BLOCK_FRAMES - 1) / BLOCK_FRAMES * BLOCK_WORDS;
+	valid.assign(words, 0);
+	referenced.assign(words, 0);
+	pinned.assign(words, 0);
+
+	//the padding past the last frame looks valid and pinned, so it is never taken
+	for(std::uint32_t i = numFrames; i < words * 64; i++) {
+		setBit(valid, i, true);
+		setBit(pinned, i, true);
+	}
+}
+
+/*
+ * Goes a word at a time up to the next block boundary, and from there a block at a time as long as
+ * blocks are passed whole. The word with the frame found is finished bit by bit: refbits are cleared
+ * only up to the frame, the same as a clock that looks at one frame at a time.
+ */
+bool FrameBitmap::sweep(FrameId from, FrameId& frame, std::uint32_t& examined)
+{
+	std::uint32_t word = from / 64;
+	std::uint32_t bit = from % 64;
+	std::uint32_t words = (std::uint32_t) valid.size();
+	std::uint32_t lastWord = (numFrames - 1) / 64;
+	examined = 0;
+
+	//two rounds and the part of the first word before the start
+	while(examined <= 2 * numFrames + 64) {
+		if(hasAvx2 && bit == 0 && word % BLOCK_WORDS == 0 && word + BLOCK_WORDS <= words) {
+#ifdef BADGERDB_FRAME_BITMAP_AVX2
+			if(blockPassedAvx2(&valid[word], &referenced[word], &pinned[word])) {
+				for(std::uint32_t i = 0; i < BLOCK_WORDS && word <= lastWord; i++, word++) {
+					examined += framesInWord(word);
+				}
+				if(word > lastWord) {
+					word = 0;
+				}
+				continue;
+			}
+#endif
+		}
+
+		std::uint64_t fromBit = ~(std::uint64_t) 0 << bit;
+		std::uint64_t takeable = (~valid[word] | (~referenced[word] & ~pinned[word])) & fromBit;
+		if(takeable != 0) {
+			std::uint32_t found = __builtin_ctzll(takeable);
+			std::uint64_t passed = fromBit & (((std::uint64_t) 1 << found) - 1);
+			referenced[word] &= ~passed;
+			examined += found - bit + 1;
+			frame = word * 64 + found;
+			return true;
+		}
+
+		referenced[word] &= ~fromBit;
+		examined += framesInWord(word) - bit;
+		bit = 0;
+		word = word == lastWord ? 0 : word + 1;
+	}
+	return false;
+}
+
+bool FrameBitmap::victimRun(std::uint32_t runFrames, FrameId& head)
+{
+	std::uint32_t runs = numFrames / runFrames;
+	if(runs == 0) {
+		return false;
+	}
+
+	//two rounds, the first may only clear refbits
+	std::uint32_t run = (hand / runFrames + 1) % runs;
+	for(std::uint32_t examined = 0; examined <= 2 * runs; examined++, run = (run + 1) % runs) {
+		FrameId start = run * runFrames;
+		bool runPinned = false;
+		bool runReferenced = false;
+		for(FrameId i = start; i < start + runFrames; i++) {
+			runPinned = runPinned || testBit(pinned, i);
+			runReferenced = runReferenced || (testBit(valid, i) && testBit(referenced, i));
+		}
+		if(runPinned) {
+			continue;
+		}
+		if(runReferenced) {
+			for(FrameId i = start; i < start + runFrames; i++) {
+				setBit(referenced, i, false);
+			}
+			continue;
+		}
+
+		hand = start + runFrames - 1;
+		head = start;
+		return true;
+	}
+	return false;
+}
+
+bool FrameBitmap::simdSweep()
+{
+	return hasAvx2;
+}
+
+}
@@ -0,0 +1,195 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "types.h"
+
+namespace badgerdb {
+
+/**
+* @brief The clock replacement policy, with the frame state it looks at packed one bit per frame into separate bitmaps.
+*
+* Holds whether each frame is valid, pinned and referenced, and the clock hand. The refbits live only here; valid
+* and pinned mirror BufDesc::valid and BufDesc::pinCnt > 0 and are kept up to date by the buffer manager. The clock
+* can then find the next frame to take from the bitmaps alone, without loading a BufDesc per frame it passes: a
+* frame is taken if it is invalid, or valid, unpinned and unreferenced. victim() and victimRun() pick the frames
+* the buffer manager evicts; what happens to the page in them is up to the buffer manager.
+*
+* The bitmaps are padded to whole blocks of BLOCK_FRAMES frames, so the sweep tests a block at a time with AVX2
+* when the CPU has it and a 64 bit word at a time otherwise. Frames in the padding count as pinned and are never
+* taken.
+*/
+class FrameBitmap
+{
+ public:
+  /**
+   * Number of frames the sweep tests at once with AVX2
+   */
+  static const std::uint32_t BLOCK_FRAMES = 256;
+
+ private:
+  /**
+   * Number of frames in the buffer pool
+   */
+  std::uint32_t numFrames;
+
+  /**
+   * Frame the clock took last, the next sweep starts past it
+   */
+  FrameId hand;
+
+  /**
+   * One bit per frame, set if the frame holds a page
+   */
+  std::vector<std::uint64_t> valid;
+
+  /**
+   * One bit per frame, set if the frame has been referenced since the clock last passed it
+   */
+  std::vector<std::uint64_t> referenced;
+
+  /**
+   * One bit per frame, set if the frame is pinned
+   */
+  std::vector<std::uint64_t> pinned;
+
+  static void setBit(std::vector<std::uint64_t>& bits, FrameId frameNo, bool value)
+  {
+    if(value)
+      bits[frameNo / 64] |= (std::uint64_t) 1 << (frameNo % 64);
+    else
+      bits[frameNo / 64] &= ~((std::uint64_t) 1 << (frameNo % 64));
+  }
+
+  static bool testBit(const std::vector<std::uint64_t>& bits, FrameId frameNo)
+  {
+    return (bits[frameNo / 64] >> (frameNo % 64)) & 1;
+  }
+
+  /**
+   * Frames of the pool in the given word
+   */
+  std::uint32_t framesInWord(std::uint32_t word) const
+  {
+    return numFrames - word * 64 < 64 ? numFrames - word * 64 : 64;
+  }
+
+ public:
+  /**
+   * Constructor of FrameBitmap class, all frames start out invalid
+   *
+   * @param numFramesIn   	Number of frames in the buffer pool
+   */
+  explicit FrameBitmap(std::uint32_t numFramesIn);
+
+  /**
+   * The frame was assigned to a page: valid, pinned once and referenced
+   */
+  void assign(FrameId frameNo)
+  {
+    setBit(valid, frameNo, true);
+    setBit(pinned, frameNo, true);
+    setBit(referenced, frameNo, true);
+  }
+
+  /**
+   * The frame was cleared: invalid, unpinned and unreferenced
+   */
+  void clear(FrameId frameNo)
+  {
+    setBit(valid, frameNo, false);
+    setBit(pinned, frameNo, false);
+    setBit(referenced, frameNo, false);
+  }
+
+  void setValid(FrameId frameNo, bool value)
+  {
+    setBit(valid, frameNo, value);
+  }
+
+  void setPinned(FrameId frameNo, bool value)
+  {
+    setBit(pinned, frameNo, value);
+  }
+
+  void setReferenced(FrameId frameNo, bool value)
+  {
+    setBit(referenced, frameNo, value);
+  }
+
+  /**
+   * Refbit of the frame
+   */
+  bool isReferenced(FrameId frameNo) const
+  {
+    return testBit(referenced, frameNo);
+  }
+
+  /**
+   * Pick the frame the next page goes into: the first one past the hand the clock may take. A frame the caller
+   * would rather not take yet, such as one holding a dirty page, is passed over while no more than the given
+   * number of frames were passed for it; the clock then takes the next one it may take after it. The hand is
+   * left at the frame picked.
+   *
+   * @param skip   	Called with a frame the clock may take, returns true to pass it over
+   * @param skipFrames   	Number of frames that may be looked at past the first one found
+   * @param frame   	Frame picked
+   * @param examined   	Number of frames looked at, including the one picked
+   * @return  False if no frame can be taken
+   */
+  template<class Skip>
+  bool victim(Skip skip, std::uint32_t skipFrames, FrameId& frame, std::uint32_t& examined)
+  {
+    if(!sweep((hand + 1) % numFrames, frame, examined)) {
+      return false;
+    }
+
+    std::uint32_t passed = 0;
+    while(passed < skipFrames && skip(frame)) {
+      //cannot fail, the frame we just passed can still be taken
+      std::uint32_t more;
+      sweep((frame + 1) % numFrames, frame, more);
+      passed += more;
+      examined += more;
+    }
+    hand = frame;
+    return true;
+  }
+
+  /**
+   * Pick a run of frames that starts at a multiple of its size and has no pinned frame. The hand moves over
+   * whole runs, giving runs that have a referenced frame a second chance, and is left at the last frame of the
+   * run picked. Frames past the last whole run are never part of a run of this size.
+   *
+   * @param runFrames   	Number of frames in the run
+   * @param head   	First frame of the run picked
+   * @return  False if every run of that size has a pinned frame
+   */
+  bool victimRun(std::uint32_t runFrames, FrameId& head);
+
+  /**
+   * Find the first frame at or after the given one, wrapping around, that the clock may take, clearing the
+   * refbits of the frames passed on the way. Gives up after two rounds, which only happens if every frame is
+   * pinned.
+   *
+   * @param from   	Frame to start at
+   * @param frame   	Frame found
+   * @param examined   	Number of frames looked at, including the one found
+   * @return  False if no frame can be taken
+   */
+  bool sweep(FrameId from, FrameId& frame, std::uint32_t& examined);
+
+  /**
+   * True if sweep() tests whole blocks with AVX2
+   */
+  static bool simdSweep();
+};
+
+}
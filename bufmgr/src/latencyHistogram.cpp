@@ -0,0 +1,73 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include "latencyHistogram.h"
+
+namespace badgerdb {
+
+/*
+ * Inverse of bucketOf: the first SUB_BUCKETS buckets hold one value each, after that bucket
+ * (m - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub covers [2^m + sub * 2^(m - SUB_BUCKET_BITS), next sub).
+ */
+std::uint64_t LatencyHistogram::highestInBucket(int bucket)
+{
+	if(bucket < SUB_BUCKETS) {
+		return bucket;
+	}
+
+	int magnitude = bucket / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+	std::uint64_t sub = bucket % SUB_BUCKETS;
+	std::uint64_t width = (std::uint64_t) 1 << (magnitude - SUB_BUCKET_BITS);
+	return ((std::uint64_t) 1 << magnitude) + (sub + 1) * width - 1;
+}
+
+std::uint64_t LatencyHistogram::percentile(double percent) const
+{
+	if(total == 0) {
+		return 0;
+	}
+
+	//the rank of the value we are after, at least the first one
+	std::uint64_t rank = (std::uint64_t) (percent / 100.0 * total + 0.5);
+	if(rank == 0) {
+		rank = 1;
+	}
+
+	std::uint64_t seen = 0;
+	for(int i = 0; i < NUM_BUCKETS; i++) {
+		seen += counts[i];
+		if(seen >= rank) {
+			//the bucket boundary can overshoot what was actually recorded
+			std::uint64_t highest = highestInBucket(i);
+			return highest < maxValue ? highest : maxValue;
+		}
+	}
+	return maxValue;
+}
+
+void LatencyHistogram::print(std::ostream& out, const std::string& name) const
+{
+	out << name << ": count:" << total
+			<< " mean:" << (std::uint64_t) mean()
+			<< " p50:" << percentile(50)
+			<< " p90:" << percentile(90)
+			<< " p99:" << percentile(99)
+			<< " p99.9:" << percentile(99.9)
+			<< " max:" << maxValue << " (ns)\n";
+}
+
+void LatencyHistogram::clear()
+{
+	for(int i = 0; i < NUM_BUCKETS; i++) {
+		counts[i] = 0;
+	}
+	total = 0;
+	sum = 0;
+	maxValue = 0;
+}
+
+}
@@ -0,0 +1,194 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+namespace badgerdb {
+
+/**
+* @brief Log-linear histogram of latencies in nanoseconds, in the style of HdrHistogram.
+*
+* Every power of two range is split into SUB_BUCKETS equal buckets, so a recorded value is off by at most
+* 1/SUB_BUCKETS of itself. Recording is a couple of shifts and one increment.
+*/
+class LatencyHistogram
+{
+ public:
+  /**
+   * log2 of the number of buckets each power of two range is split into
+   */
+  static const int SUB_BUCKET_BITS = 5;
+
+  /**
+   * Number of buckets each power of two range is split into
+   */
+  static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+
+  /**
+   * Total number of buckets, enough for any 64 bit value
+   */
+  static const int NUM_BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+ private:
+  /**
+   * Number of values recorded in each bucket
+   */
+  std::uint64_t counts[NUM_BUCKETS];
+
+  /**
+   * Number of values recorded
+   */
+  std::uint64_t total;
+
+  /**
+   * Sum of the values recorded
+   */
+  std::uint64_t sum;
+
+  /**
+   * Largest value recorded
+   */
+  std::uint64_t maxValue;
+
+  /**
+   * Bucket a value is counted in
+   */
+  static int bucketOf(std::uint64_t value)
+  {
+    if(value < (std::uint64_t) SUB_BUCKETS)
+      return (int) value;
+
+    int magnitude = 63 - __builtin_clzll(value);
+    int sub = (int) ((value >> (magnitude - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1));
+    return (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+  }
+
+  /**
+   * Largest value that is counted in the bucket
+   */
+  static std::uint64_t highestInBucket(int bucket);
+
+ public:
+  /**
+   * Constructor of LatencyHistogram class
+   */
+  LatencyHistogram()
+  {
+    clear();
+  }
+
+  /**
+   * Record one value
+   *
+   * @param nanos   	Latency in nanoseconds
+   */
+  void record(std::uint64_t nanos)
+  {
+    counts[bucketOf(nanos)]++;
+    total++;
+    sum += nanos;
+    if(nanos > maxValue)
+      maxValue = nanos;
+  }
+
+  /**
+   * Number of values recorded
+   */
+  std::uint64_t count() const
+  {
+    return total;
+  }
+
+  /**
+   * Mean of the values recorded, 0 if nothing was recorded
+   */
+  double mean() const
+  {
+    return total == 0 ? 0.0 : (double) sum / total;
+  }
+
+  /**
+   * Largest value recorded
+   */
+  std::uint64_t max() const
+  {
+    return maxValue;
+  }
+
+  /**
+   * Value at or below which the given percentage of the recorded values fall, rounded up to the bucket boundary.
+   *
+   * @param percent   	Percentile between 0 and 100
+   */
+  std::uint64_t percentile(double percent) const;
+
+  /**
+   * Print count, mean, the usual percentiles and the maximum on one line
+   *
+   * @param out   	Stream to print to
+   * @param name   	Label printed in front of the values
+   */
+  void print(std::ostream& out, const std::string& name) const;
+
+  /**
+   * Forget all recorded values
+   */
+  void clear();
+};
+
+
+/**
+* @brief Measures the time from its construction until stop(), or until mark() if it was called, when enabled,
+* and does nothing otherwise.
+*/
+class LatencyTimer
+{
+ private:
+  bool enabled;
+  bool marked;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point end;
+
+ public:
+  explicit LatencyTimer(bool enabledIn)
+    : enabled(enabledIn), marked(false)
+  {
+    if(enabled)
+      start = std::chrono::steady_clock::now();
+  }
+
+  /**
+   * End the measured time here, for when it ends at a point where the histogram cannot be touched yet.
+   * stop() records it later.
+   */
+  void mark()
+  {
+    if(enabled)
+    {
+      end = std::chrono::steady_clock::now();
+      marked = true;
+    }
+  }
+
+  /**
+   * Record the time elapsed since construction, up to mark() if it was called
+   *
+   * @param histogram   	Histogram the time is recorded in
+   */
+  void stop(LatencyHistogram& histogram)
+  {
+    if(enabled)
+      histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>((marked ? end : std::chrono::steady_clock::now()) - start).count());
+  }
+};
+
+}
@@ -0,0 +1,2513 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstdio>
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "page.h"
+#include "buffer.h"
+#include "bufPoolRegistry.h"
+#include "bulkLoader.h"
+#include "checksumFile.h"
+#include "compressedCache.h"
+#include "compressedPageStore.h"
+#include "crc32c.h"
+#include "doubleWriteBuffer.h"
+#include "flashCache.h"
+#include "frameBitmap.h"
+#include "mappedFile.h"
+#include "file_iterator.h"
+#include "page_iterator.h"
+#include "exceptions/file_not_found_exception.h"
+#include "exceptions/invalid_page_exception.h"
+#include "exceptions/page_not_pinned_exception.h"
+#include "exceptions/latch_not_held_exception.h"
+#include "exceptions/page_pinned_exception.h"
+#include "exceptions/buffer_exceeded_exception.h"
+#include "exceptions/pool_exists_exception.h"
+#include "exceptions/pool_not_found_exception.h"
+#include "exceptions/grant_pinned_exception.h"
+#include "exceptions/page_checksum_exception.h"
+
+#define PRINT_ERROR(str) \
+{ \
+	std::cerr << "On Line No:" << __LINE__ << "\n"; \
+	std::cerr << str << "\n"; \
+	exit(1); \
+}
+
+using namespace badgerdb;
+
+const PageId num = 100;
+PageId pid[num], pageno1, pageno2, pageno3, i;
+RecordId rid[num], rid2, rid3;
+Page *page, *page2, *page3;
+char tmpbuf[100];
+BufMgr* bufMgr;
+File *file1ptr, *file2ptr, *file3ptr, *file4ptr, *file5ptr;
+
+void test1();
+void test2();
+void test3();
+void test4();
+void test5();
+void test6();
+void testBufMgr();
+void testBufPoolRegistry();
+void testWarmUp();
+void testBufStats();
+void testLatency();
+void testPageHandle();
+void testLatches();
+void testOptimisticReads();
+void testPageRefs();
+void testFrameWait();
+void testGrants();
+void testScanRing();
+void testBulkLoader();
+void testAllocPages();
+void testDispose();
+void testChecksums();
+void testDoubleWrite();
+void testCompressedStore();
+void testSecondTier();
+void testFlashCache();
+void testMappedFile();
+void testRuns();
+void testSingleThreaded();
+void testFrameBitmap();
+void testCleanVictims();
+void testConcurrentMisses();
+
+/*
+ * Removes a file, also if an earlier run did not get to clean up.
+ */
+void removeFile(const std::string& filename)
+{
+	try
+	{
+		File::remove(filename);
+	}
+	catch(const FileNotFoundException& e)
+	{
+	}
+}
+
+/*
+ * Checks that the record written by the tests for the given page reads back unchanged.
+ */
+void checkRecord(const Page* page, const RecordId& rid, const char* test, PageId pageNo)
+{
+	sprintf(tmpbuf, "%s Page %d %7.1f", test, pageNo, (float)pageNo);
+	if(strncmp(page->getRecord(rid).c_str(), tmpbuf, strlen(tmpbuf)) != 0)
+	{
+		PRINT_ERROR("ERROR :: CONTENTS DID NOT MATCH");
+	}
+}
+
+int main()
+{
+	testBufMgr();
+	testBufPoolRegistry();
+	testWarmUp();
+	testBufStats();
+	testLatency();
+	testPageHandle();
+	testLatches();
+	testOptimisticReads();
+	testPageRefs();
+	testFrameWait();
+	testGrants();
+	testScanRing();
+	testBulkLoader();
+	testAllocPages();
+	testDispose();
+	testChecksums();
+	testDoubleWrite();
+	testCompressedStore();
+	testSecondTier();
+	testFlashCache();
+	testMappedFile();
+	testRuns();
+	testSingleThreaded();
+	testFrameBitmap();
+	testCleanVictims();
+	testConcurrentMisses();
+
+	return 0;
+}
+
+void testBufMgr()
+{
+	// create buffer manager
+	bufMgr = new BufMgr(num);
+
+	// create dummy files
+	const std::string filename1 = "test.1";
+	const std::string filename2 = "test.2";
+	const std::string filename3 = "test.3";
+	const std::string filename4 = "test.4";
+	const std::string filename5 = "test.5";
+
+	removeFile(filename1);
+	removeFile(filename2);
+	removeFile(filename3);
+	removeFile(filename4);
+	removeFile(filename5);
+
+	{
+		PageFile file1 = PageFile::create(filename1);
+		PageFile file2 = PageFile::create(filename2);
+		PageFile file3 = PageFile::create(filename3);
+		PageFile file4 = PageFile::create(filename4);
+		PageFile file5 = PageFile::create(filename5);
+
+		file1ptr = &file1;
+		file2ptr = &file2;
+		file3ptr = &file3;
+		file4ptr = &file4;
+		file5ptr = &file5;
+
+		//Test buffer manager
+		//Comment tests which you do not wish to run now. Tests are dependent on their preceding tests. So, they have to be run in the following order.
+		//Commenting  a particular test requires commenting all tests that follow it else those tests would fail.
+		test1();
+		test2();
+		test3();
+		test4();
+		test5();
+		test6();
+
+		//the buffer manager writes its dirty pages back when it is deleted, so it goes before the files close
+		delete bufMgr;
+	}
+
+	removeFile(filename1);
+	removeFile(filename2);
+	removeFile(filename3);
+	removeFile(filename4);
+	removeFile(filename5);
+
+	std::cout << "\n" << "Passed all tests." << "\n";
+}
+
+void test1()
+{
+	//Allocating pages in a file...
+	for (i = 0; i < num; i++)
+	{
+		bufMgr->allocPage(file1ptr, pid[i], page);
+		sprintf((char*)tmpbuf, "test.1 Page %d %7.1f", pid[i], (float)pid[i]);
+		rid[i] = page->insertRecord(tmpbuf);
+		bufMgr->unPinPage(file1ptr, pid[i], true);
+	}
+
+	//Reading pages back...
+	for (i = 0; i < num; i++)
+	{
+		bufMgr->readPage(file1ptr, pid[i], page);
+		checkRecord(page, rid[i], "test.1", pid[i]);
+		bufMgr->unPinPage(file1ptr, pid[i], false);
+	}
+	std::cout<< "Test 1 passed" << "\n";
+}
+
+void test2()
+{
+	//Writing and reading back multiple files
+	//The page number and the value should match
+
+	for (i = 0; i < num/3; i++)
+	{
+		bufMgr->allocPage(file2ptr, pageno2, page2);
+		sprintf((char*)tmpbuf, "test.2 Page %d %7.1f", pageno2, (float)pageno2);
+		rid2 = page2->insertRecord(tmpbuf);
+
+		int index = random() % num;
+		pageno1 = pid[index];
+		bufMgr->readPage(file1ptr, pageno1, page);
+		checkRecord(page, rid[index], "test.1", pageno1);
+
+		bufMgr->allocPage(file3ptr, pageno3, page3);
+		sprintf((char*)tmpbuf, "test.3 Page %d %7.1f", pageno3, (float)pageno3);
+		rid3 = page3->insertRecord(tmpbuf);
+
+		bufMgr->readPage(file2ptr, pageno2, page2);
+		checkRecord(page2, rid2, "test.2", pageno2);
+
+		bufMgr->readPage(file3ptr, pageno3, page3);
+		checkRecord(page3, rid3, "test.3", pageno3);
+
+		bufMgr->unPinPage(file1ptr, pageno1, false);
+	}
+
+	for (i = 0; i < num/3; i++) {
+		bufMgr->unPinPage(file2ptr, i+1, true);
+		bufMgr->unPinPage(file2ptr, i+1, true);
+		bufMgr->unPinPage(file3ptr, i+1, true);
+		bufMgr->unPinPage(file3ptr, i+1, true);
+	}
+
+	std::cout << "Test 2 passed" << "\n";
+}
+
+void test3()
+{
+	try
+	{
+		bufMgr->readPage(file4ptr, 1, page);
+		PRINT_ERROR("ERROR :: File4 should not exist. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const InvalidPageException& e)
+	{
+	}
+
+	std::cout << "Test 3 passed" << "\n";
+}
+
+void test4()
+{
+	bufMgr->allocPage(file4ptr, i, page);
+	bufMgr->unPinPage(file4ptr, i, true);
+	try
+	{
+		bufMgr->unPinPage(file4ptr, i, false);
+		PRINT_ERROR("ERROR :: Page is already unpinned. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const PageNotPinnedException& e)
+	{
+	}
+
+	std::cout << "Test 4 passed" << "\n";
+}
+
+void test5()
+{
+	for (i = 0; i < num; i++) {
+		bufMgr->allocPage(file5ptr, pid[i], page);
+		sprintf((char*)tmpbuf, "test.5 Page %d %7.1f", pid[i], (float)pid[i]);
+		rid[i] = page->insertRecord(tmpbuf);
+	}
+
+	PageId tmp;
+	try
+	{
+		bufMgr->allocPage(file5ptr, tmp, page);
+		PRINT_ERROR("ERROR :: No more frames left for allocation. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const BufferExceededException& e)
+	{
+	}
+
+	std::cout << "Test 5 passed" << "\n";
+
+	for (i = 1; i <= num; i++)
+		bufMgr->unPinPage(file5ptr, i, true);
+}
+
+void test6()
+{
+	//flushing file with pages still pinned. Should generate an error
+	for (i = 1; i <= num; i++) {
+		bufMgr->readPage(file1ptr, i, page);
+	}
+
+	try
+	{
+		bufMgr->flushFile(file1ptr);
+		PRINT_ERROR("ERROR :: Pages pinned for file being flushed. Exception should have been thrown before execution reaches this point.");
+	}
+	catch(const PagePinnedException& e)
+	{
+	}
+
+	std::cout << "Test 6 passed" << "\n";
+
+	for (i = 1; i <= num; i++)
+		bufMgr->unPinPage(file1ptr, i, true);
+
+	bufMgr->flushFile(file1ptr);
+}
+
+void testBufPoolRegistry()
+{
+	const std::string filename = "test.registry";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufPoolRegistry registry(10);
+
+		registry.createPool("scan", 5);
+		try
+		{
+			registry.createPool("scan", 5);
+			PRINT_ERROR("ERROR :: Pool already exists. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const PoolExistsException& e)
+		{
+		}
+
+		try
+		{
+			registry.getPool("missing");
+			PRINT_ERROR("ERROR :: Pool does not exist. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const PoolNotFoundException& e)
+		{
+		}
+
+		BufMgr* scanPool = registry.getPool("scan");
+		BufMgr* defaultPool = registry.getPool(BufPoolRegistry::DEFAULT_POOL);
+		if(registry.poolFor(&file) != defaultPool)
+		{
+			PRINT_ERROR("ERROR :: A file that was never bound should go to the default pool.");
+		}
+
+		registry.bindFile(&file, "scan");
+		if(registry.poolFor(&file) != scanPool)
+		{
+			PRINT_ERROR("ERROR :: A bound file should go to its pool.");
+		}
+		registry.allocPage(&file, pageno1, page);
+		sprintf(tmpbuf, "registry Page %d %7.1f", pageno1, (float)pageno1);
+		rid2 = page->insertRecord(tmpbuf);
+		registry.unPinPage(&file, pageno1, true);
+		if(scanPool->getBufStats().accesses == 0 || defaultPool->getBufStats().accesses != 0)
+		{
+			PRINT_ERROR("ERROR :: Pages of a bound file should only go through its pool.");
+		}
+
+		//moving the file back writes its dirty page out of the scan pool, so the default pool reads it from disk
+		registry.unbindFile(&file);
+		registry.readPage(&file, pageno1, page);
+		checkRecord(page, rid2, "registry", pageno1);
+		registry.unPinPage(&file, pageno1, false);
+		if(defaultPool->getBufStats().diskreads != 1)
+		{
+			PRINT_ERROR("ERROR :: The default pool should have read the page from disk.");
+		}
+
+#ifndef BADGERDB_BUF_SINGLE_THREADED
+		//pools are created and looked up from several threads at once
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+		{
+			threads.push_back(std::thread([&registry, &file, t]() {
+				for (int p = 0; p < 20; p++)
+				{
+					registry.createPool("thread" + std::to_string(t) + "." + std::to_string(p), 1);
+					registry.poolFor(&file);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < threads.size(); t++)
+			threads[t].join();
+		try
+		{
+			registry.getPool("thread3.19");
+		}
+		catch(const PoolNotFoundException& e)
+		{
+			PRINT_ERROR("ERROR :: Every pool created by a thread should be registered.");
+		}
+#endif
+	}
+	removeFile(filename);
+
+	std::cout << "BufPoolRegistry test passed" << "\n";
+}
+
+void testWarmUp()
+{
+	const std::string filename = "test.warmup";
+	const std::string listname = "test.resident";
+	removeFile(filename);
+	std::remove(listname.c_str());
+
+	{
+		PageFile file = PageFile::create(filename);
+		std::vector<File*> files(1, &file);
+
+		{
+			BufMgr mgr(10);
+			mgr.setResidentListPath(listname);
+			for (i = 0; i < 5; i++)
+			{
+				mgr.allocPage(&file, pid[i], page);
+				sprintf(tmpbuf, "warmup Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+				mgr.unPinPage(&file, pid[i], true);
+			}
+			//the destructor writes the pages back and saves the list
+		}
+
+		{
+			//a list larger than the pool fills the free frames and stops
+			BufMgr mgr(3);
+			if(mgr.warmUp(listname, files) != 3)
+			{
+				PRINT_ERROR("ERROR :: Warm-up should stop when the pool is full.");
+			}
+		}
+
+		{
+			BufMgr mgr(10);
+			if(mgr.warmUp(listname, std::vector<File*>()) != 0)
+			{
+				PRINT_ERROR("ERROR :: Entries for files that were not given should be skipped.");
+			}
+			if(mgr.warmUp(listname, files) != 5)
+			{
+				PRINT_ERROR("ERROR :: Every page in the list should have been loaded.");
+			}
+
+			//with the pages gone from the file, only the pool can still serve them
+			for (i = 0; i < 5; i++)
+			{
+				file.deletePage(pid[i]);
+			}
+			mgr.clearBufStats();
+			for (i = 0; i < 5; i++)
+			{
+				mgr.readPage(&file, pid[i], page);
+				checkRecord(page, rid[i], "warmup", pid[i]);
+				mgr.unPinPage(&file, pid[i], false);
+			}
+			if(mgr.getBufStats().hits != 5 || mgr.getBufStats().diskreads != 0)
+			{
+				PRINT_ERROR("ERROR :: Pages loaded by warm-up should be hits.");
+			}
+		}
+	}
+	removeFile(filename);
+	std::remove(listname.c_str());
+
+	std::cout << "Warm-up test passed" << "\n";
+}
+
+void testBufStats()
+{
+	const std::string filename = "test.stats";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(3);
+
+		for (i = 0; i < 3; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+		mgr.clearBufStats();
+
+		//the pool is full of dirty pages, so the fourth one evicts and writes back one of them
+		mgr.allocPage(&file, pid[3], page);
+		mgr.unPinPage(&file, pid[3], false);
+		BufStats stats = mgr.getBufStats();
+		if(stats.evictions != 1 || stats.dirtyEvictions != 1 || stats.diskwrites != 1)
+		{
+			PRINT_ERROR("ERROR :: Allocating into a full pool should evict one dirty page.");
+		}
+
+		std::uint64_t sweeps = 0;
+		for (int b = 0; b < BufStats::SWEEP_BUCKETS; b++)
+			sweeps += stats.sweepLengths[b];
+		if(sweeps != 1)
+		{
+			PRINT_ERROR("ERROR :: The one clock sweep should have been counted.");
+		}
+
+		mgr.readPage(&file, pid[3], page);
+		mgr.unPinPage(&file, pid[3], false);
+		stats = mgr.getBufStats();
+		if(stats.hits != 1 || stats.misses != 0)
+		{
+			PRINT_ERROR("ERROR :: Reading a resident page should count as a hit.");
+		}
+
+		//one of the first three pages is no longer resident; allocPage counted as a disk read as well
+		for (i = 0; i < 3; i++)
+		{
+			mgr.readPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], false);
+		}
+		stats = mgr.getBufStats();
+		if(stats.hits + stats.misses != 4 || stats.misses == 0 || (int) stats.misses + 1 != stats.diskreads)
+		{
+			PRINT_ERROR("ERROR :: Every read should be either a hit or a miss that went to disk.");
+		}
+
+		BufStats snapshot = mgr.getBufStatsSnapshot();
+		if(snapshot.files[filename].hits != stats.hits || snapshot.files[filename].misses != stats.misses)
+		{
+			PRINT_ERROR("ERROR :: Per file counts should add up to the pool's.");
+		}
+
+		mgr.flushFile(&file);
+		stats = mgr.getBufStats();
+		if(stats.flushes != 1)
+		{
+			PRINT_ERROR("ERROR :: The flush should have been counted.");
+		}
+
+		mgr.clearBufStats();
+		stats = mgr.getBufStats();
+		if(stats.hits != 0 || stats.evictions != 0 || stats.flushes != 0)
+		{
+			PRINT_ERROR("ERROR :: Clearing the statistics should zero them.");
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "BufStats test passed" << "\n";
+}
+
+void testLatency()
+{
+	LatencyHistogram histogram;
+	for (std::uint64_t v = 1; v <= 1000; v++)
+		histogram.record(v * 1000);
+	if(histogram.count() != 1000 || histogram.max() != 1000000)
+	{
+		PRINT_ERROR("ERROR :: The histogram should count every value and keep the largest.");
+	}
+	//buckets are at most 1/32 of their values wide
+	std::uint64_t median = histogram.percentile(50);
+	if(median < 500000 || median > 500000 + 500000 / 32 || histogram.percentile(100) < histogram.max())
+	{
+		PRINT_ERROR("ERROR :: Percentiles should be rounded up to a bucket boundary close to the value.");
+	}
+
+	const std::string filename = "test.latency";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(2);
+
+		//nothing is recorded until tracking is turned on
+		mgr.allocPage(&file, pid[0], page);
+		mgr.unPinPage(&file, pid[0], true);
+		if(mgr.getBufLatency().allocBuf.count() != 0)
+		{
+			PRINT_ERROR("ERROR :: Latencies should not be recorded while tracking is off.");
+		}
+
+		mgr.setLatencyTracking(true);
+		for (i = 1; i < 4; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+		mgr.readPage(&file, pid[3], page);
+		mgr.unPinPage(&file, pid[3], false);
+		mgr.readPage(&file, pid[0], page);
+		mgr.unPinPage(&file, pid[0], false);
+
+		BufLatency latency = mgr.getBufLatency();
+		if(latency.readHit.count() != 1 || latency.readMiss.count() != 1 || latency.fileRead.count() != 1)
+		{
+			PRINT_ERROR("ERROR :: One hit and one miss that read from the file should have been timed.");
+		}
+		if(latency.allocBuf.count() != 4 || latency.fileWrite.count() == 0)
+		{
+			PRINT_ERROR("ERROR :: Every frame allocation and the write-backs of dirty victims should have been timed.");
+		}
+
+		mgr.clearBufLatency();
+		latency = mgr.getBufLatency();
+		if(latency.readHit.count() != 0 || latency.allocBuf.count() != 0)
+		{
+			PRINT_ERROR("ERROR :: Clearing the histograms should empty them.");
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Latency histogram test passed" << "\n";
+}
+
+void testPageHandle()
+{
+	const std::string filename = "test.handle";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(1);
+
+		{
+			PageHandle handle = mgr.allocPage(&file, pageno1);
+			sprintf(tmpbuf, "handle Page %d %7.1f", pageno1, (float)pageno1);
+			rid2 = handle->insertRecord(tmpbuf);
+			handle.markDirty();
+
+			//moving hands the pin over, only the last holder unpins
+			PageHandle moved(std::move(handle));
+			if(handle || !moved)
+			{
+				PRINT_ERROR("ERROR :: A moved-from handle should hold no pin.");
+			}
+
+			try
+			{
+				mgr.disposePage(&file, pageno1);
+				PRINT_ERROR("ERROR :: Page is pinned. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const PagePinnedException& e)
+			{
+			}
+		}
+
+		//the handle unpinned the page dirty, so it can be flushed and read back
+		mgr.flushFile(&file);
+		{
+			PageHandle handle = mgr.readPage(&file, pageno1);
+			checkRecord(handle.get(), rid2, "handle", pageno1);
+		}
+
+		//a handle whose pin was dropped by page number leaves whatever reuses its frame alone
+		{
+			PageHandle handle = mgr.readPage(&file, pageno1);
+			mgr.unPinPage(&file, pageno1, false);
+			mgr.allocPage(&file, pageno2, page);
+			handle.release();
+			mgr.unPinPage(&file, pageno2, false);
+			try
+			{
+				mgr.unPinPage(&file, pageno2, false);
+				PRINT_ERROR("ERROR :: Page is already unpinned. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const PageNotPinnedException& e)
+			{
+			}
+		}
+
+		//and so does one whose page was disposed, leaving an empty frame
+		{
+			PageHandle handle = mgr.readPage(&file, pageno2);
+			mgr.unPinPage(&file, pageno2, false);
+			mgr.disposePage(&file, pageno2);
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "PageHandle test passed" << "\n";
+}
+
+void testLatches()
+{
+	const std::string filename = "test.latch";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(4);
+		mgr.allocPage(&file, pageno1, page);
+		mgr.unPinPage(&file, pageno1, true);
+
+		{
+			PageHandle first = mgr.readPage(&file, pageno1, LATCH_SHARED);
+			PageHandle second = mgr.readPage(&file, pageno1, LATCH_SHARED);
+			if(first.tryUpgrade())
+			{
+				PRINT_ERROR("ERROR :: A shared latch held by two handles should not upgrade.");
+			}
+			second.release();
+			if(!first.tryUpgrade() || first.mode() != LATCH_EXCLUSIVE)
+			{
+				PRINT_ERROR("ERROR :: The only holder of a shared latch should be able to upgrade it.");
+			}
+			first.downgrade();
+			if(first.mode() != LATCH_SHARED)
+			{
+				PRINT_ERROR("ERROR :: Downgrading should leave the latch shared.");
+			}
+		}
+
+#ifndef BADGERDB_BUF_SINGLE_THREADED
+		//a reader has to wait for the writer to let go of the page
+		std::atomic<bool> readerIn(false);
+		std::thread reader;
+		{
+			PageHandle writer = mgr.readPage(&file, pageno1, LATCH_EXCLUSIVE);
+			reader = std::thread([&]() {
+				PageHandle handle = mgr.readPage(&file, pageno1, LATCH_SHARED);
+				readerIn = true;
+			});
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			if(readerIn)
+			{
+				PRINT_ERROR("ERROR :: A shared latch should not be granted while the page is latched exclusively.");
+			}
+		}
+		reader.join();
+		if(!readerIn)
+		{
+			PRINT_ERROR("ERROR :: The reader should get the latch once the writer released it.");
+		}
+#endif
+
+		//the by-pointer calls latch and unlatch the same way
+		mgr.readPage(&file, pageno1, page, LATCH_EXCLUSIVE);
+		mgr.unPinPage(&file, pageno1, false, LATCH_EXCLUSIVE);
+		{
+			PageHandle handle = mgr.readPage(&file, pageno1, LATCH_SHARED);
+			if(!handle.tryUpgrade())
+			{
+				PRINT_ERROR("ERROR :: unPinPage should have released the exclusive latch.");
+			}
+		}
+
+		//a page latched in another mode, or not pinned at all, is refused without touching its latch
+		mgr.readPage(&file, pageno1, page, LATCH_SHARED);
+		try
+		{
+			mgr.unPinPage(&file, pageno1, false, LATCH_EXCLUSIVE);
+			PRINT_ERROR("ERROR :: Releasing a latch mode the page is not latched in should throw.");
+		}
+		catch(const LatchNotHeldException& e)
+		{
+		}
+		mgr.unPinPage(&file, pageno1, false, LATCH_SHARED);
+		try
+		{
+			mgr.unPinPage(&file, pageno1, false, LATCH_SHARED);
+			PRINT_ERROR("ERROR :: Unpinning a page that is not pinned should throw.");
+		}
+		catch(const PageNotPinnedException& e)
+		{
+		}
+		{
+			PageHandle handle = mgr.readPage(&file, pageno1, LATCH_EXCLUSIVE);
+			if(handle.mode() != LATCH_EXCLUSIVE)
+			{
+				PRINT_ERROR("ERROR :: The refused calls should have left the latch free.");
+			}
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Page latch test passed" << "\n";
+}
+
+void testOptimisticReads()
+{
+	const std::string filename = "test.optimistic";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(1);
+		mgr.allocPage(&file, pageno1, page);
+		sprintf(tmpbuf, "optimistic Page %d %7.1f", pageno1, (float)pageno1);
+		rid2 = page->insertRecord(tmpbuf);
+		mgr.unPinPage(&file, pageno1, true);
+
+		std::uint64_t version = mgr.readPageOptimistic(&file, pageno1, page);
+		checkRecord(page, rid2, "optimistic", pageno1);
+		if(!mgr.validatePage(page, version))
+		{
+			PRINT_ERROR("ERROR :: A read nobody interfered with should validate.");
+		}
+
+		//the page comes back unpinned
+		mgr.flushFile(&file);
+
+		//a writer holding the page exclusively invalidates the read
+		version = mgr.readPageOptimistic(&file, pageno1, page);
+		{
+			PageHandle writer = mgr.readPage(&file, pageno1, LATCH_EXCLUSIVE);
+			writer.markDirty();
+		}
+		if(mgr.validatePage(page, version))
+		{
+			PRINT_ERROR("ERROR :: A read that overlapped an exclusive latch should not validate.");
+		}
+
+		//and so does the frame being given to another page
+		version = mgr.readPageOptimistic(&file, pageno1, page);
+		mgr.allocPage(&file, pageno2, page2);
+		mgr.unPinPage(&file, pageno2, false);
+		if(mgr.validatePage(page, version))
+		{
+			PRINT_ERROR("ERROR :: A read of an evicted page should not validate.");
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Optimistic read test passed" << "\n";
+}
+
+void testPageRefs()
+{
+	const std::string filename = "test.pageref";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(2);
+		mgr.allocPage(&file, pageno1, page);
+		sprintf(tmpbuf, "pageref Page %d %7.1f", pageno1, (float)pageno1);
+		rid2 = page->insertRecord(tmpbuf);
+		mgr.unPinPage(&file, pageno1, true);
+
+		PageRef ref(&file, pageno1);
+		if(ref.isSwizzled())
+		{
+			PRINT_ERROR("ERROR :: A new reference should not be swizzled.");
+		}
+		mgr.readPage(ref, page);
+		mgr.unPinPage(&file, pageno1, false);
+
+		//a second reference to the same page is not swizzled, the frame already has one
+		PageRef other(&file, pageno1);
+		mgr.readPage(other, page2);
+		mgr.unPinPage(&file, pageno1, false);
+		if(!ref.isSwizzled() || other.isSwizzled() || page2 != page)
+		{
+			PRINT_ERROR("ERROR :: Only the first reference to a page should be swizzled.");
+		}
+
+		{
+			PageHandle handle = mgr.readPage(ref, LATCH_SHARED);
+			checkRecord(handle.get(), rid2, "pageref", pageno1);
+		}
+
+		//moving carries the link to the frame along
+		PageRef moved(std::move(ref));
+		if(ref.isSwizzled() || !moved.isSwizzled())
+		{
+			PRINT_ERROR("ERROR :: Moving a swizzled reference should move the link.");
+		}
+
+		//flushing drops the page from the pool, which unswizzles the reference
+		mgr.flushFile(&file);
+		if(moved.isSwizzled())
+		{
+			PRINT_ERROR("ERROR :: A reference to a page that left the pool should be unswizzled.");
+		}
+		mgr.readPage(moved, page);
+		checkRecord(page, rid2, "pageref", pageno1);
+		mgr.unPinPage(&file, pageno1, false);
+		if(!moved.isSwizzled())
+		{
+			PRINT_ERROR("ERROR :: Reading the page again should swizzle the reference again.");
+		}
+
+		//a reference that goes away unlinks itself, so the next one can be swizzled
+		{
+			PageRef scoped(std::move(moved));
+		}
+		mgr.readPage(other, page);
+		mgr.unPinPage(&file, pageno1, false);
+		if(!other.isSwizzled())
+		{
+			PRINT_ERROR("ERROR :: The frame should have been free for another reference.");
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "PageRef test passed" << "\n";
+}
+
+void testFrameWait()
+{
+#ifndef BADGERDB_BUF_SINGLE_THREADED
+	const std::string filename = "test.wait";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(1);
+		mgr.allocPage(&file, pageno1, page);
+
+		//without a timeout a full pool fails right away, as before
+		try
+		{
+			mgr.allocPage(&file, pageno2, page2);
+			PRINT_ERROR("ERROR :: Every frame is pinned. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+		if(mgr.getBufStats().pinWaits != 0)
+		{
+			PRINT_ERROR("ERROR :: Nothing should have waited without a timeout.");
+		}
+
+		//with one, a frame nobody unpins is waited for until the timeout runs out
+		mgr.setFrameWaitTimeout(std::chrono::milliseconds(20));
+		try
+		{
+			mgr.allocPage(&file, pageno2, page2);
+			PRINT_ERROR("ERROR :: Nobody unpinned a frame. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+		if(mgr.getBufStats().pinWaits != 1 || mgr.getBufStats().pinWaitTimeouts != 1)
+		{
+			PRINT_ERROR("ERROR :: The wait and its timeout should have been counted.");
+		}
+
+		//a frame unpinned by another thread goes to the waiting one
+		mgr.setFrameWaitTimeout(std::chrono::milliseconds(5000));
+		std::thread unpinner([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			mgr.unPinPage(&file, pageno1, false);
+		});
+		mgr.allocPage(&file, pageno2, page2);
+		unpinner.join();
+		mgr.unPinPage(&file, pageno2, false);
+		if(mgr.getBufStats().pinWaits != 2 || mgr.getBufStats().pinWaitTimeouts != 1)
+		{
+			PRINT_ERROR("ERROR :: The second wait should have ended with a frame.");
+		}
+	}
+	removeFile(filename);
+
+	{
+		//a hit on an unpinned page over the quota waits in line like a miss instead of failing right away
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(3);
+		BufGrant* grant = mgr.reserveFrames(1);
+		mgr.allocPage(&file, pageno2, page2);
+		mgr.unPinPage(&file, pageno2, true);
+		mgr.allocPage(&file, pageno1, page, grant);
+
+		mgr.setFrameWaitTimeout(std::chrono::milliseconds(5000));
+		std::thread unpinner([&]() {
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			mgr.unPinPage(&file, pageno1, false);
+		});
+		mgr.readPage(&file, pageno2, page2, LATCH_NONE, grant);
+		unpinner.join();
+		if(mgr.getBufStats().pinWaits != 1 || mgr.getBufStats().misses != 0 || grant->getPinned() != 1)
+		{
+			PRINT_ERROR("ERROR :: The hit should have waited for the quota and been charged to the grant.");
+		}
+		mgr.unPinPage(&file, pageno2, false);
+		mgr.releaseGrant(grant);
+	}
+	removeFile(filename);
+
+	std::cout << "Frame wait test passed" << "\n";
+#endif
+}
+
+void testGrants()
+{
+	const std::string filename = "test.grant";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(4);
+		mgr.setUnreservedHeadroom(1);
+
+		try
+		{
+			mgr.reserveFrames(4);
+			PRINT_ERROR("ERROR :: One frame is kept out of reach. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+
+		//clients without a grant share the two frames that are not reserved, even with the others free
+		BufGrant* grant = mgr.reserveFrames(2);
+		mgr.allocPage(&file, pid[0], page);
+		mgr.allocPage(&file, pid[1], page);
+		try
+		{
+			mgr.allocPage(&file, pid[2], page);
+			PRINT_ERROR("ERROR :: The unreserved frames are all pinned. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+
+		mgr.allocPage(&file, pid[2], page, grant);
+		mgr.allocPage(&file, pid[3], page, grant);
+		if(grant->getPinned() != 2)
+		{
+			PRINT_ERROR("ERROR :: Both pages should have been charged to the grant.");
+		}
+		try
+		{
+			mgr.allocPage(&file, pid[4], page, grant);
+			PRINT_ERROR("ERROR :: The grant has no frame left. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+
+		//a page pinned by the grant stays charged to it when someone else pins it as well
+		mgr.readPage(&file, pid[2], page);
+		mgr.unPinPage(&file, pid[2], false);
+		if(grant->getPinned() != 2)
+		{
+			PRINT_ERROR("ERROR :: Pinning a page again should not move its charge.");
+		}
+
+		try
+		{
+			mgr.releaseGrant(grant);
+			PRINT_ERROR("ERROR :: Pages are still charged to the grant. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const GrantPinnedException& e)
+		{
+		}
+
+		for (i = 0; i < 4; i++)
+			mgr.unPinPage(&file, pid[i], true);
+		if(grant->getPinned() != 0)
+		{
+			PRINT_ERROR("ERROR :: Unpinning should have given the frames back to the grant.");
+		}
+		mgr.releaseGrant(grant);
+
+		//with the grant gone the whole pool but the headroom can be reserved again
+		mgr.releaseGrant(mgr.reserveFrames(3));
+
+		//a request over its quota is turned away before the clock evicts a page for it
+		grant = mgr.reserveFrames(1);
+		mgr.readPage(&file, pid[0], page, LATCH_NONE, grant);
+		mgr.clearBufStats();
+		try
+		{
+			mgr.allocPage(&file, pid[4], page, grant);
+			PRINT_ERROR("ERROR :: The grant has no frame left. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+		if(mgr.getBufStats().evictions != 0)
+		{
+			PRINT_ERROR("ERROR :: A request over its quota should not have evicted anything.");
+		}
+		for (i = 1; i < 4; i++)
+		{
+			mgr.readPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], false);
+		}
+		if(mgr.getBufStats().hits != 3)
+		{
+			PRINT_ERROR("ERROR :: The other pages should still be in the pool.");
+		}
+		mgr.unPinPage(&file, pid[0], false);
+		mgr.releaseGrant(grant);
+	}
+	removeFile(filename);
+
+	std::cout << "BufGrant test passed" << "\n";
+}
+
+void testScanRing()
+{
+	const std::string hotname = "test.hot";
+	const std::string scanname = "test.scan";
+	removeFile(hotname);
+	removeFile(scanname);
+
+	{
+		PageFile hot = PageFile::create(hotname);
+		PageFile scan = PageFile::create(scanname);
+		for (i = 0; i < 20; i++)
+			pid[i] = scan.allocatePage().page_number();
+
+		BufMgr mgr(10);
+		for (i = 20; i < 25; i++)
+		{
+			mgr.allocPage(&hot, pid[i], page);
+			mgr.unPinPage(&hot, pid[i], true);
+		}
+
+		//a scan twice the size of the pool only ever takes the two frames of its ring
+		BufAccessStrategy* strategy = mgr.getAccessStrategy(2);
+		mgr.clearBufStats();
+		for (i = 0; i < 20; i++)
+		{
+			mgr.readPage(&scan, pid[i], page, strategy);
+			mgr.unPinPage(&scan, pid[i], false);
+		}
+		if(mgr.getBufStats().ringReuses != 18)
+		{
+			PRINT_ERROR("ERROR :: Every page after the first two should have reused a frame of the ring.");
+		}
+
+		//so the pages that were there before are still there
+		mgr.clearBufStats();
+		for (i = 20; i < 25; i++)
+		{
+			mgr.readPage(&hot, pid[i], page);
+			mgr.unPinPage(&hot, pid[i], false);
+		}
+		if(mgr.getBufStats().misses != 0)
+		{
+			PRINT_ERROR("ERROR :: The scan should not have pushed other pages out of the pool.");
+		}
+
+		//a page the scan finds resident is pinned where it is and does not join the ring
+		mgr.readPage(&hot, pid[20], page, strategy);
+		mgr.unPinPage(&hot, pid[20], false);
+		if(mgr.getBufStats().misses != 0)
+		{
+			PRINT_ERROR("ERROR :: A resident page should be a hit for a scan as well.");
+		}
+		mgr.freeAccessStrategy(strategy);
+	}
+	removeFile(hotname);
+	removeFile(scanname);
+
+	std::cout << "Scan ring test passed" << "\n";
+}
+
+void testBulkLoader()
+{
+	const std::string filename = "test.bulk";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+
+		{
+			//the last page is only written by commit()
+			BulkLoader loader(&file);
+			for (i = 0; i < 10; i++)
+			{
+				page = loader.newPage(pid[i]);
+				sprintf(tmpbuf, "bulk Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+			}
+			if(loader.pageCount() != 10)
+			{
+				PRINT_ERROR("ERROR :: The loader should have allocated ten pages.");
+			}
+			loader.commit();
+		}
+
+		BufMgr mgr(3);
+		for (i = 0; i < 10; i++)
+		{
+			mgr.readPage(&file, pid[i], page);
+			checkRecord(page, rid[i], "bulk", pid[i]);
+			mgr.unPinPage(&file, pid[i], false);
+		}
+
+		//a load that is not committed takes its pages with it
+		{
+			BulkLoader loader(&file);
+			for (i = 10; i < 15; i++)
+				loader.newPage(pid[i]);
+		}
+		for (i = 10; i < 15; i++)
+		{
+			try
+			{
+				mgr.readPage(&file, pid[i], page);
+				PRINT_ERROR("ERROR :: The load was aborted. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+
+		//runs of four pages, the third only written by commit(); the file takes in all of them
+		{
+			BulkLoader loader(&file, 4);
+			for (i = 0; i < 10; i++)
+			{
+				page = loader.newPage(pid[i]);
+				sprintf(tmpbuf, "bulk Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+				if(i > 0 && pid[i] != pid[i - 1] + 1)
+				{
+					PRINT_ERROR("ERROR :: The pages of a load should be numbered one after the other.");
+				}
+			}
+			loader.commit();
+		}
+		for (i = 0; i < 10; i++)
+		{
+			mgr.readPage(&file, pid[i], page);
+			checkRecord(page, rid[i], "bulk", pid[i]);
+			mgr.unPinPage(&file, pid[i], false);
+		}
+		Page next = file.allocatePage();
+		if(next.page_number() != pid[9] + 1)
+		{
+			PRINT_ERROR("ERROR :: A page allocated after the load should come after its pages.");
+		}
+
+		//an aborted load deletes the runs it wrote and never writes the rest
+		{
+			BulkLoader loader(&file, 4);
+			for (i = 0; i < 6; i++)
+				loader.newPage(pid[i]);
+		}
+		for (i = 0; i < 6; i++)
+		{
+			try
+			{
+				mgr.readPage(&file, pid[i], page);
+				PRINT_ERROR("ERROR :: The load was aborted. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "BulkLoader test passed" << "\n";
+}
+
+void testAllocPages()
+{
+	const std::string filename = "test.allocpages";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(4);
+		std::vector<PageId> pageNos;
+		std::vector<Page*> pages;
+		mgr.allocPage(&file, pageno1, page);
+
+		//three frames are left, so asking for four gets nothing and leaves the file alone
+		try
+		{
+			mgr.allocPages(&file, 4, pageNos, pages);
+			PRINT_ERROR("ERROR :: Not enough frames are free. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+		int fileSize = 0;
+		for (FileIterator it = file.begin(); it != file.end(); ++it)
+			fileSize++;
+		if(fileSize != 1)
+		{
+			PRINT_ERROR("ERROR :: A failed allocPages should not allocate pages in the file.");
+		}
+
+		mgr.allocPages(&file, 3, pageNos, pages);
+		if(pageNos.size() != 3 || pages.size() != 3)
+		{
+			PRINT_ERROR("ERROR :: Three pages should have been allocated.");
+		}
+		for (i = 0; i < 3; i++)
+		{
+			sprintf(tmpbuf, "allocpages Page %d %7.1f", pageNos[i], (float)pageNos[i]);
+			rid[i] = pages[i]->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageNos[i], true);
+		}
+		mgr.unPinPage(&file, pageno1, false);
+
+		mgr.flushFile(&file);
+		for (i = 0; i < 3; i++)
+		{
+			mgr.readPage(&file, pageNos[i], page);
+			checkRecord(page, rid[i], "allocpages", pageNos[i]);
+			mgr.unPinPage(&file, pageNos[i], false);
+		}
+	}
+
+	//a victim that cannot be written back fails the call, and the frames taken before it go back to the pool
+	{
+		const std::string othername = "test.allocpages2";
+		removeFile(othername);
+		PageFile file = PageFile::open(filename);
+		PageFile other = PageFile::create(othername);
+		BufMgr mgr(4);
+		std::vector<PageId> pageNos;
+		std::vector<Page*> pages;
+		mgr.allocPage(&other, pageno2, page);
+		mgr.unPinPage(&other, pageno2, true);
+		other.deletePage(pageno2);
+
+		try
+		{
+			mgr.allocPages(&file, 4, pageNos, pages);
+			PRINT_ERROR("ERROR :: The dirty page cannot be written. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InvalidPageException& e)
+		{
+		}
+		if(!pageNos.empty() || !pages.empty())
+		{
+			PRINT_ERROR("ERROR :: A failed allocPages should not return any pages.");
+		}
+
+		mgr.allocPages(&file, 3, pageNos, pages);
+		for (i = 0; i < 3; i++)
+			mgr.unPinPage(&file, pageNos[i], false);
+		mgr.disposeFile(&other);
+	}
+	removeFile(filename);
+	removeFile("test.allocpages2");
+
+	std::cout << "allocPages test passed" << "\n";
+}
+
+void testDispose()
+{
+	const std::string filename = "test.dispose";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(10);
+		for (i = 0; i < 10; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+
+		//the first three disposed pages wait in the queue, still in the file
+		mgr.setDisposeBatch(4);
+		for (i = 0; i < 3; i++)
+			mgr.disposePage(&file, pid[i]);
+		for (i = 0; i < 3; i++)
+			file.readPage(pid[i]);
+		mgr.drainDisposeQueue();
+		for (i = 0; i < 3; i++)
+		{
+			try
+			{
+				file.readPage(pid[i]);
+				PRINT_ERROR("ERROR :: Page was deleted. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+
+		//the fourth one sends the batch to the background
+		for (i = 3; i < 7; i++)
+			mgr.disposePage(&file, pid[i]);
+		mgr.drainDisposeQueue();
+		for (i = 3; i < 7; i++)
+		{
+			try
+			{
+				file.readPage(pid[i]);
+				PRINT_ERROR("ERROR :: Page was deleted. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+
+		//disposeFile leaves everything alone while a page of the file is pinned
+		mgr.disposePage(&file, pid[7]);
+		mgr.readPage(&file, pid[8], page);
+		try
+		{
+			mgr.disposeFile(&file);
+			PRINT_ERROR("ERROR :: Page is pinned. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const PagePinnedException& e)
+		{
+		}
+		mgr.unPinPage(&file, pid[8], false);
+		mgr.clearBufStats();
+		mgr.readPage(&file, pid[9], page);
+		mgr.unPinPage(&file, pid[9], false);
+		if(mgr.getBufStats().hits != 1)
+		{
+			PRINT_ERROR("ERROR :: A disposeFile that failed should not have dropped any page.");
+		}
+
+		//once it goes through, the pages have left the pool and the queued page is forgotten
+		mgr.disposeFile(&file);
+		mgr.drainDisposeQueue();
+		file.readPage(pid[7]);
+		mgr.clearBufStats();
+		mgr.readPage(&file, pid[9], page);
+		mgr.unPinPage(&file, pid[9], false);
+		if(mgr.getBufStats().misses != 1)
+		{
+			PRINT_ERROR("ERROR :: The pages of the file should have left the pool.");
+		}
+
+		//a page that cannot be deleted fails its batch, which reports it and collects it again
+		mgr.setDisposeBatch(2);
+		for (i = 10; i < 12; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+		file.deletePage(pid[10]);
+		mgr.disposePage(&file, pid[10]);
+		try
+		{
+			//built for one thread, the batch is deleted right here
+			mgr.disposePage(&file, pid[11]);
+		}
+		catch(const InvalidPageException& e)
+		{
+		}
+		for (int attempt = 0; attempt < 2; attempt++)
+		{
+			try
+			{
+				mgr.drainDisposeQueue();
+				PRINT_ERROR("ERROR :: A page of the batch was already gone. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+		try
+		{
+			file.readPage(pid[11]);
+			PRINT_ERROR("ERROR :: Page was deleted. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InvalidPageException& e)
+		{
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Dispose test passed" << "\n";
+}
+
+void testChecksums()
+{
+	//the check value of CRC32C, whole and in two pieces
+	const char* check = "123456789";
+	if(crc32c(check, 9) != 0xE3069283 || crc32c(check + 4, 5, crc32c(check, 4)) != 0xE3069283)
+	{
+		PRINT_ERROR("ERROR :: CRC32C of the check string is wrong.");
+	}
+
+	const std::string filename = "test.checksum";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		//checksums are on unless turned off
+		BufMgr mgr(1);
+		mgr.allocPage(&file, pageno1, page);
+		sprintf(tmpbuf, "checksum Page %d %7.1f", pageno1, (float)pageno1);
+		rid2 = page->insertRecord(tmpbuf);
+		mgr.unPinPage(&file, pageno1, true);
+		mgr.flushFile(&file);
+
+		mgr.readPage(&file, pageno1, page);
+		checkRecord(page, rid2, "checksum", pageno1);
+		mgr.unPinPage(&file, pageno1, false);
+		mgr.flushFile(&file);
+
+		//a page changed behind the pool's back no longer matches
+		Page changed = file.readPage(pageno1);
+		changed.insertRecord("changed");
+		file.writePage(changed);
+		try
+		{
+			mgr.readPage(&file, pageno1, page);
+			PRINT_ERROR("ERROR :: Page does not match its checksum. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const PageChecksumException& e)
+		{
+		}
+
+		//the CRCs are in the checksum file, so a pool started later knows them as well
+		{
+			BufMgr restarted(1);
+			try
+			{
+				restarted.readPage(&file, pageno1, page);
+				PRINT_ERROR("ERROR :: Page does not match its checksum. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const PageChecksumException& e)
+			{
+			}
+		}
+
+		//unless the pool was told to forget what it wrote
+		mgr.forgetChecksums(&file);
+		mgr.readPage(&file, pageno1, page);
+		checkRecord(page, rid2, "checksum", pageno1);
+		mgr.unPinPage(&file, pageno1, false);
+		if(mgr.getBufStats().checksumsComputed != 1)
+		{
+			PRINT_ERROR("ERROR :: Only the one write-back should have been checksummed.");
+		}
+
+		//a page written with checksums off loses its old CRC instead of keeping a stale one
+		mgr.readPage(&file, pageno1, page);
+		mgr.unPinPage(&file, pageno1, true);
+		mgr.flushFile(&file);
+		mgr.readPage(&file, pageno1, page);
+		mgr.unPinPage(&file, pageno1, true);
+		mgr.setChecksums(false);
+		mgr.flushFile(&file);
+		mgr.setChecksums(true);
+		changed = file.readPage(pageno1);
+		changed.insertRecord("changed again");
+		file.writePage(changed);
+		mgr.readPage(&file, pageno1, page);
+		mgr.unPinPage(&file, pageno1, false);
+
+		//leave a CRC behind for the next file of this name
+		mgr.readPage(&file, pageno1, page);
+		mgr.unPinPage(&file, pageno1, true);
+		mgr.flushFile(&file);
+	}
+	removeFile(filename);
+
+	//the checksum file outlives its data file, but is not taken for the checksums of a new one
+	if(!ChecksumFile::exists(filename))
+	{
+		PRINT_ERROR("ERROR :: Removing the data file should have left its checksum file behind.");
+	}
+	{
+		PageFile file = PageFile::create(filename);
+		Page fresh = file.allocatePage();
+		fresh.insertRecord("recreated");
+		file.writePage(fresh);
+
+		BufMgr mgr(1);
+		try
+		{
+			mgr.readPage(&file, fresh.page_number(), page);
+			mgr.unPinPage(&file, fresh.page_number(), false);
+		}
+		catch(const PageChecksumException& e)
+		{
+			PRINT_ERROR("ERROR :: The CRCs of the removed file should not apply to the new one.");
+		}
+	}
+	removeFile(filename);
+	ChecksumFile::remove(filename);
+
+	std::cout << "Checksum test passed" << "\n";
+}
+
+void testDoubleWrite()
+{
+	//the name is longer than a slot header could hold, recovery has to find the file all the same
+	const std::string filename = "test.dw" + std::string(240, 'w');
+	const std::string areaname = "test.dwarea";
+	removeFile(filename);
+	std::remove(areaname.c_str());
+
+	{
+		PageFile file = PageFile::create(filename);
+		std::vector<File*> files(1, &file);
+
+		{
+			BufMgr mgr(1);
+			mgr.setDoubleWrite(areaname, 2);
+			mgr.allocPage(&file, pageno1, page);
+			sprintf(tmpbuf, "dw Page %d %7.1f", pageno1, (float)pageno1);
+			rid2 = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pageno1, true);
+
+			//evicting the page puts it in the batch, which is not full yet
+			mgr.allocPage(&file, pageno2, page);
+			mgr.unPinPage(&file, pageno2, true);
+			if(file.readPage(pageno1).getRecord(rid2) != "" || mgr.getBufStats().doubleWriteFlushes != 0)
+			{
+				PRINT_ERROR("ERROR :: The page should still be waiting in the batch.");
+			}
+
+			//a miss finds it there, and evicting the second page fills the batch
+			mgr.readPage(&file, pageno1, page);
+			checkRecord(page, rid2, "dw", pageno1);
+			mgr.unPinPage(&file, pageno1, false);
+
+			//the full batch is written in the background
+			for(int i = 0; i < 100 && mgr.getBufStatsSnapshot().doubleWriteFlushes == 0; i++)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			if(mgr.getBufStats().doubleWriteFlushes != 1 || mgr.getBufStats().doubleWritePages != 2)
+			{
+				PRINT_ERROR("ERROR :: The full batch should have been written.");
+			}
+			Page written = file.readPage(pageno1);
+			checkRecord(&written, rid2, "dw", pageno1);
+		}
+
+		if(DoubleWriteBuffer::recover(areaname, files) != 0)
+		{
+			PRINT_ERROR("ERROR :: A batch that was written in place completely should not be replayed.");
+		}
+
+		//a batch whose second page cannot be written in place stops after the first, like a crash would,
+		//and tearing the first page in place then leaves recovery to put it back
+		const std::string othername = "test.dwother";
+		removeFile(othername);
+		{
+			PageFile other = PageFile::create(othername);
+			Page deleted = other.allocatePage();
+			other.deletePage(deleted.page_number());
+
+			Page old = file.readPage(pageno2);
+			Page updated = old;
+			sprintf(tmpbuf, "dw Page %d %7.1f", pageno2, (float)pageno2);
+			rid3 = updated.insertRecord(tmpbuf);
+			{
+				DoubleWriteBuffer area(areaname, 2);
+				area.add(&file, updated);
+				area.add(&other, deleted);
+				try
+				{
+					area.flush();
+					PRINT_ERROR("ERROR :: Page was deleted. Exception should have been thrown before execution reaches this point.");
+				}
+				catch(const InvalidPageException& e)
+				{
+				}
+			}
+			file.writePage(old);
+		}
+		removeFile(othername);
+
+		if(DoubleWriteBuffer::recover(areaname, std::vector<File*>()) != 0)
+		{
+			PRINT_ERROR("ERROR :: Pages of files that were not given should be skipped.");
+		}
+		if(DoubleWriteBuffer::recover(areaname, files) != 1)
+		{
+			PRINT_ERROR("ERROR :: The page of the last batch should have been written back.");
+		}
+		Page recovered = file.readPage(pageno2);
+		checkRecord(&recovered, rid3, "dw", pageno2);
+
+		//a crash during recovery only means running it again
+		if(DoubleWriteBuffer::recover(areaname, files) != 1)
+		{
+			PRINT_ERROR("ERROR :: Recovering again should write the same page back again.");
+		}
+		recovered = file.readPage(pageno2);
+		checkRecord(&recovered, rid3, "dw", pageno2);
+	}
+	removeFile(filename);
+	std::remove(areaname.c_str());
+
+	std::cout << "Double-write test passed" << "\n";
+}
+
+void testCompressedStore()
+{
+	const std::string filename = "test.lz4file";
+	const std::string storename = "test.lz4store";
+	removeFile(filename);
+	std::remove(storename.c_str());
+	std::remove((storename + ".map").c_str());
+
+	{
+		PageFile file = PageFile::create(filename);
+
+		{
+			//the store has to outlive the buffer manager, which writes its pages back when it goes
+			CompressedPageStore store(storename);
+			BufMgr mgr(1);
+			mgr.setCompressedStore(&file, &store);
+			for (i = 0; i < 3; i++)
+			{
+				mgr.allocPage(&file, pid[i], page);
+				sprintf(tmpbuf, "lz4 Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+				mgr.unPinPage(&file, pid[i], true);
+			}
+			struct stat before;
+			stat(filename.c_str(), &before);
+			mgr.flushFile(&file);
+
+			//a mostly empty page shrinks to a slot or two
+			if(store.pageCount() != 3 || store.compressedBytes() >= Page::SIZE)
+			{
+				PRINT_ERROR("ERROR :: The pages should have been written to the store, compressed.");
+			}
+			if(file.readPage(pid[0]).getRecord(rid[0]) != "")
+			{
+				PRINT_ERROR("ERROR :: The pages should not have been written to the file.");
+			}
+			//the empty pages the file wrote when it allocated them are punched out once the store has them
+			struct stat after;
+			stat(filename.c_str(), &after);
+			if(after.st_blocks >= before.st_blocks)
+			{
+				PRINT_ERROR("ERROR :: The file's copies of the stored pages should have been released.");
+			}
+			for (i = 0; i < 3; i++)
+			{
+				mgr.readPage(&file, pid[i], page);
+				checkRecord(page, rid[i], "lz4", pid[i]);
+				mgr.unPinPage(&file, pid[i], false);
+			}
+
+			mgr.disposePage(&file, pid[2]);
+			if(store.pageCount() != 2)
+			{
+				PRINT_ERROR("ERROR :: A disposed page should have left the store.");
+			}
+		}
+
+		//what was synced is there after the store is opened again
+		CompressedPageStore store(storename);
+		Page stored;
+		if(store.pageCount() != 2 || !store.readPage(pid[1], stored) || store.readPage(pid[2], stored))
+		{
+			PRINT_ERROR("ERROR :: The mapping table should have been read back.");
+		}
+		store.readPage(pid[1], stored);
+		checkRecord(&stored, rid[1], "lz4", pid[1]);
+
+		//a disposed file takes its pages in the store along
+		{
+			BufMgr mgr(1);
+			mgr.setCompressedStore(&file, &store);
+			mgr.disposeFile(&file);
+		}
+		if(store.pageCount() != 0 || store.readPage(pid[1], stored))
+		{
+			PRINT_ERROR("ERROR :: Disposing of the file should have emptied its store.");
+		}
+
+		//slots freed next to each other make room for a larger page
+		Page small[3];
+		for (i = 0; i < 3; i++)
+		{
+			small[i] = file.allocatePage();
+			store.writePage(small[i]);
+		}
+		std::uint64_t end = store.fileBytes();
+		store.erase(small[0].page_number());
+		store.erase(small[1].page_number());
+		store.sync();
+		//random letters do not compress, the page needs more than one slot of a small one
+		Page large = file.allocatePage();
+		std::string letters(700, ' ');
+		std::uint32_t seed = 1;
+		for (std::size_t j = 0; j < letters.size(); j++)
+		{
+			seed = seed * 1103515245 + 12345;
+			letters[j] = 'a' + (seed >> 16) % 26;
+		}
+		RecordId largeRid = large.insertRecord(letters);
+		store.writePage(large);
+		if(store.fileBytes() != end)
+		{
+			PRINT_ERROR("ERROR :: The freed slots should have been merged and reused.");
+		}
+		store.readPage(large.page_number(), stored);
+		if(stored.getRecord(largeRid) != letters)
+		{
+			PRINT_ERROR("ERROR :: The page in the merged slot should read back.");
+		}
+
+		//free space at the end of the data file is given back
+		store.erase(small[2].page_number());
+		store.erase(large.page_number());
+		store.sync();
+		struct stat data;
+		stat(storename.c_str(), &data);
+		if(store.fileBytes() != 0 || data.st_size != 0)
+		{
+			PRINT_ERROR("ERROR :: The free tail of the data file should have been cut off.");
+		}
+	}
+	removeFile(filename);
+	std::remove(storename.c_str());
+	std::remove((storename + ".map").c_str());
+
+	std::cout << "Compressed store test passed" << "\n";
+}
+
+void testSecondTier()
+{
+	const std::string filename = "test.tier";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+
+		{
+			BufMgr mgr(1);
+			mgr.setSecondTier(1 << 20);
+			for (i = 0; i < 3; i++)
+			{
+				mgr.allocPage(&file, pid[i], page);
+				sprintf(tmpbuf, "tier Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+				mgr.unPinPage(&file, pid[i], true);
+			}
+			if(mgr.getBufStats().secondTierStores != 2)
+			{
+				PRINT_ERROR("ERROR :: Both evicted pages should have gone to the second tier.");
+			}
+
+			//a miss takes the page out of the tier instead of reading the file
+			mgr.clearBufStats();
+			mgr.readPage(&file, pid[0], page);
+			checkRecord(page, rid[0], "tier", pid[0]);
+			mgr.unPinPage(&file, pid[0], false);
+			if(mgr.getBufStats().secondTierHits != 1 || mgr.getBufStats().diskreads != 0)
+			{
+				PRINT_ERROR("ERROR :: The page should have come from the second tier.");
+			}
+
+			//a disposed page must not come back from the tier
+			mgr.disposePage(&file, pid[1]);
+			try
+			{
+				mgr.readPage(&file, pid[1], page);
+				PRINT_ERROR("ERROR :: Page was disposed. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+
+		//a tier with room for two and a half pages drops the one stored first to make room for a third
+		Page pages[3];
+		for (i = 0; i < 3; i++)
+		{
+			pages[i] = file.allocatePage();
+			sprintf(tmpbuf, "tier Page %d %7.1f", pages[i].page_number(), (float)pages[i].page_number());
+			pages[i].insertRecord(tmpbuf);
+		}
+		CompressedCache sizing(1 << 20);
+		sizing.put(&file, pages[0]);
+		CompressedCache tier(sizing.bytes() * 5 / 2);
+		for (i = 0; i < 3; i++)
+			tier.put(&file, pages[i]);
+		Page taken;
+		if(tier.size() != 2 || tier.take(&file, pages[0].page_number(), taken))
+		{
+			PRINT_ERROR("ERROR :: The page stored first should have been dropped.");
+		}
+		if(!tier.take(&file, pages[2].page_number(), taken) || tier.size() != 1 || tier.take(&file, pages[2].page_number(), taken))
+		{
+			PRINT_ERROR("ERROR :: A page taken out of the tier should leave it.");
+		}
+		if(CompressedCache(16).put(&file, pages[0]))
+		{
+			PRINT_ERROR("ERROR :: A page larger than the tier should not be kept.");
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Second tier test passed" << "\n";
+}
+
+void testFlashCache()
+{
+	const std::string filename = "test.slow";
+	const std::string cachename = "test.flash";
+	removeFile(filename);
+	std::remove(cachename.c_str());
+
+	{
+		PageFile file = PageFile::create(filename);
+
+		{
+			BufMgr mgr(1);
+			mgr.setFlashCache(cachename, 4);
+			for (i = 0; i < 2; i++)
+			{
+				mgr.allocPage(&file, pid[i], page);
+				sprintf(tmpbuf, "flash Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+				mgr.unPinPage(&file, pid[i], true);
+			}
+			if(mgr.getBufStats().flashAdmits != 1)
+			{
+				PRINT_ERROR("ERROR :: The evicted page should have been admitted to the cache.");
+			}
+
+			mgr.clearBufStats();
+			mgr.readPage(&file, pid[0], page);
+			checkRecord(page, rid[0], "flash", pid[0]);
+			if(mgr.getBufStats().flashHits != 1 || mgr.getBufStats().diskreads != 0)
+			{
+				PRINT_ERROR("ERROR :: The page should have been read from the cache.");
+			}
+
+			//flushing the file drops its pages from the cache, the file may be closed and its File object reused
+			mgr.unPinPage(&file, pid[0], true);
+			mgr.flushFile(&file);
+			mgr.clearBufStats();
+			mgr.readPage(&file, pid[1], page);
+			checkRecord(page, rid[1], "flash", pid[1]);
+			mgr.unPinPage(&file, pid[1], false);
+			if(mgr.getBufStats().flashHits != 0 || mgr.getBufStats().diskreads != 1)
+			{
+				PRINT_ERROR("ERROR :: Pages of a flushed file should have been read from the file.");
+			}
+
+			//until they are evicted again
+			mgr.readPage(&file, pid[0], page);
+			mgr.unPinPage(&file, pid[0], false);
+			mgr.readPage(&file, pid[1], page);
+			checkRecord(page, rid[1], "flash", pid[1]);
+			mgr.unPinPage(&file, pid[1], false);
+			if(mgr.getBufStats().flashHits != 1)
+			{
+				PRINT_ERROR("ERROR :: The evicted page should have been read from the cache.");
+			}
+		}
+
+		//a full cache makes room for a new page
+		FlashCache cache(cachename, 2);
+		for (i = 0; i < 3; i++)
+			cache.admit(&file, file.allocatePage());
+		if(cache.size() != 2)
+		{
+			PRINT_ERROR("ERROR :: The cache should hold no more pages than it has slots.");
+		}
+
+		//a page that is cached already is not written again
+		Page cached = file.allocatePage();
+		cache.admit(&file, cached);
+		Page changed = cached;
+		rid[0] = changed.insertRecord("flash changed");
+		cache.admit(&file, changed);
+		Page stored;
+		if(!cache.lookup(&file, cached.page_number(), stored) || stored.getRecord(rid[0]) != "")
+		{
+			PRINT_ERROR("ERROR :: Admitting a cached page again should have left the cached copy alone.");
+		}
+		cache.eraseFile(&file);
+		if(cache.size() != 0)
+		{
+			PRINT_ERROR("ERROR :: Dropping the file should have emptied the cache.");
+		}
+	}
+	removeFile(filename);
+	std::remove(cachename.c_str());
+
+	std::cout << "Flash cache test passed" << "\n";
+}
+
+void testMappedFile()
+{
+	const std::string filename = "test.export";
+	const std::string mapname = "test.mapped";
+	removeFile(filename);
+	std::remove(mapname.c_str());
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(1);
+		for (i = 0; i < 4; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			sprintf(tmpbuf, "mapped Page %d %7.1f", pid[i], (float)pid[i]);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+		mgr.flushFile(&file);
+		mgr.disposePage(&file, pid[2]);
+
+		if(MappedFile::exportFile(&file, mapname) != 3)
+		{
+			PRINT_ERROR("ERROR :: The three pages left in the file should have been exported.");
+		}
+
+		MappedFile mapped(mapname);
+		const Page* mappedPage;
+		const Page* again;
+		const Page* other;
+
+		//mapped pages take no frame, so they can be pinned while the only one is
+		mgr.allocPage(&file, pageno1, page);
+		mgr.clearBufStats();
+		mgr.readPage(&mapped, pid[0], mappedPage);
+		mgr.readPage(&mapped, pid[0], again);
+		mgr.readPage(&mapped, pid[3], other);
+		checkRecord(mappedPage, rid[0], "mapped", pid[0]);
+		checkRecord(other, rid[3], "mapped", pid[3]);
+		if(again != mappedPage || mapped.pinnedCount() != 2 || mgr.getBufStats().diskreads != 0)
+		{
+			PRINT_ERROR("ERROR :: A page pinned twice should be the same page, read from the mapping.");
+		}
+		mgr.unPinPage(&file, pageno1, false);
+
+		try
+		{
+			mgr.readPage(&mapped, pid[2], again);
+			PRINT_ERROR("ERROR :: Page was deleted before the export. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InvalidPageException& e)
+		{
+		}
+
+		mgr.unPinPage(&mapped, pid[0]);
+		mgr.unPinPage(&mapped, pid[0]);
+		mgr.unPinPage(&mapped, pid[3]);
+		try
+		{
+			mgr.unPinPage(&mapped, pid[3]);
+			PRINT_ERROR("ERROR :: Page is already unpinned. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const PageNotPinnedException& e)
+		{
+		}
+		if(mapped.pinnedCount() != 0)
+		{
+			PRINT_ERROR("ERROR :: Every mapped page should have been unpinned.");
+		}
+
+		//unpinned pages are kept, so pinning them again copies nothing
+		mgr.readPage(&mapped, pid[0], again);
+		if(again != mappedPage || mapped.idleCount() != 1)
+		{
+			PRINT_ERROR("ERROR :: A page pinned again should be the page kept from its last pin.");
+		}
+		mgr.unPinPage(&mapped, pid[0]);
+
+		//up to the limit, the page unpinned longest ago goes first
+		MappedFile small(mapname, 1);
+		mgr.readPage(&small, pid[0], mappedPage);
+		mgr.unPinPage(&small, pid[0]);
+		mgr.readPage(&small, pid[1], other);
+		mgr.unPinPage(&small, pid[1]);
+		if(small.idleCount() != 1)
+		{
+			PRINT_ERROR("ERROR :: No more unpinned pages than the limit should have been kept.");
+		}
+	}
+	removeFile(filename);
+	std::remove(mapname.c_str());
+
+	std::cout << "Mapped file test passed" << "\n";
+}
+
+void testRuns()
+{
+	const std::string filename = "test.run";
+	const std::string othername = "test.runother";
+	removeFile(filename);
+	removeFile(othername);
+
+	{
+		PageFile file = PageFile::create(filename);
+		PageFile other = PageFile::create(othername);
+		BufMgr mgr(8);
+
+		//pages of another file in between scatter the pages of the run over the pool
+		mgr.allocPage(&file, pageno1, page);
+		mgr.unPinPage(&file, pageno1, false);
+		for (i = 0; i < 3; i++)
+		{
+			mgr.allocPage(&other, pageno2, page);
+			mgr.unPinPage(&other, pageno2, false);
+			mgr.allocPage(&file, pid[i], page);
+			sprintf(tmpbuf, "run Page %d %7.1f", pid[i], (float)pid[i]);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+
+		//resident pages are moved into the run, unless taking the frames of the run evicted them first
+		Page* run;
+		mgr.clearBufStats();
+		mgr.readRun(&file, pid[0], 3, run);
+		if((run - mgr.bufPool) % 4 != 0 || mgr.getBufStats().hits + mgr.getBufStats().misses != 3)
+		{
+			PRINT_ERROR("ERROR :: The pages should have gone to a run of frames aligned to its size.");
+		}
+		for (i = 0; i < 3; i++)
+			checkRecord(&run[i], rid[i], "run", pid[i]);
+
+		//each page of the run is an ordinary page as well
+		mgr.readPage(&file, pid[1], page);
+		if(page != &run[1])
+		{
+			PRINT_ERROR("ERROR :: Reading a page of the run should give its frame in the run.");
+		}
+		mgr.unPinPage(&file, pid[1], false);
+		mgr.unPinRun(&file, pid[0], 3, false);
+
+		//a run that is already together is pinned where it is
+		Page* again;
+		mgr.readRun(&file, pid[0], 3, again);
+		mgr.unPinRun(&file, pid[0], 3, false);
+		if(again != run)
+		{
+			PRINT_ERROR("ERROR :: A run already in place should not move.");
+		}
+
+		//a pinned page is not moved, and a run can be no larger than the pool
+		mgr.readPage(&file, pageno1, page);
+		try
+		{
+			mgr.readRun(&file, pageno1, 2, run);
+			PRINT_ERROR("ERROR :: Page is pinned. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const PagePinnedException& e)
+		{
+		}
+		mgr.unPinPage(&file, pageno1, false);
+		try
+		{
+			mgr.readRun(&file, pageno1, 9, run);
+			PRINT_ERROR("ERROR :: The run is larger than the pool. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const BufferExceededException& e)
+		{
+		}
+
+		//the pages kept their dirty bits through the move
+		mgr.flushFile(&file);
+		for (i = 0; i < 3; i++)
+		{
+			Page written = file.readPage(pid[i]);
+			checkRecord(&written, rid[i], "run", pid[i]);
+		}
+
+		//a run that fails partway leaves none of its pages pinned
+		try
+		{
+			mgr.readRun(&file, pid[1], 3, run);
+			PRINT_ERROR("ERROR :: The last page of the run does not exist. Exception should have been thrown before execution reaches this point.");
+		}
+		catch(const InvalidPageException& e)
+		{
+		}
+		mgr.flushFile(&file);
+		mgr.readRun(&file, pid[0], 3, run);
+		mgr.unPinRun(&file, pid[0], 3, false);
+	}
+	removeFile(filename);
+	removeFile(othername);
+
+	std::cout << "Page run test passed" << "\n";
+}
+
+void testSingleThreaded()
+{
+	const std::string filename = "test.single";
+	removeFile(filename);
+
+	{
+		//a pool built for one thread, whatever BufMgr is in this build
+		typedef BasicBufMgr<ClockReplacement, NullMutex> SingleBufMgr;
+		PageFile file = PageFile::create(filename);
+		SingleBufMgr mgr(4);
+		for (i = 0; i < 2; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			sprintf(tmpbuf, "single Page %d %7.1f", pid[i], (float)pid[i]);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+		{
+			SingleBufMgr::PageHandle handle = mgr.readPage(&file, pid[1]);
+			checkRecord(handle.get(), rid[1], "single", pid[1]);
+		}
+
+		//there is no background task, the batch is deleted as soon as it is full
+		mgr.setDisposeBatch(2);
+		mgr.disposePage(&file, pid[0]);
+		file.readPage(pid[0]);
+		mgr.disposePage(&file, pid[1]);
+		for (i = 0; i < 2; i++)
+		{
+			try
+			{
+				file.readPage(pid[i]);
+				PRINT_ERROR("ERROR :: Page was deleted. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Single-threaded test passed" << "\n";
+}
+
+void testFrameBitmap()
+{
+	//pool sizes around word and block boundaries, so the padding and the last partial word get swept as well
+	const std::uint32_t sizes[] = { 1, 63, 64, 65, 255, 256, 300, 700 };
+	srand(564);
+
+	for (std::uint32_t n : sizes)
+	{
+		for (int round = 0; round < 200; round++)
+		{
+			//mostly pinned or referenced frames, so sweeps get long and often pass whole blocks
+			FrameBitmap bits(n);
+			std::vector<bool> valid(n), pinned(n), referenced(n);
+			int takeable = rand() % 4;
+			for (FrameId f = 0; f < n; f++)
+			{
+				valid[f] = rand() % 64 != 0 || takeable == 0;
+				pinned[f] = valid[f] && rand() % 8 < (takeable == 3 ? 8 : 5);
+				referenced[f] = valid[f] && !pinned[f] && (takeable != 1 || rand() % 16 != 0);
+				bits.setValid(f, valid[f]);
+				bits.setPinned(f, pinned[f]);
+				bits.setReferenced(f, referenced[f]);
+			}
+
+			//the clock one frame at a time, as it was before the bitmaps
+			FrameId from = rand() % n;
+			bool expectFound = false;
+			FrameId expectFrame = 0;
+			std::uint32_t expectExamined = 0;
+			for (FrameId f = from; expectExamined < 2 * n; f = (f + 1) % n)
+			{
+				expectExamined++;
+				if(!valid[f] || (!pinned[f] && !referenced[f]))
+				{
+					expectFound = true;
+					expectFrame = f;
+					break;
+				}
+				referenced[f] = false;
+			}
+
+			FrameId frame;
+			std::uint32_t examined;
+			bool found = bits.sweep(from, frame, examined);
+			if(found != expectFound || (found && (frame != expectFrame || examined != expectExamined)))
+			{
+				PRINT_ERROR("ERROR :: The sweep should stop where a clock going one frame at a time stops.");
+			}
+			for (FrameId f = 0; f < n; f++)
+			{
+				if(bits.isReferenced(f) != referenced[f])
+				{
+					PRINT_ERROR("ERROR :: The sweep should clear the refbits of exactly the frames it passed.");
+				}
+			}
+		}
+	}
+
+	//the clock picks the frames to evict and keeps its hand between picks
+	{
+		FrameBitmap bits(8);
+		bits.assign(1);
+		FrameId frame;
+		std::uint32_t examined;
+		//frames passed over still count, a frame past the limit is taken anyway
+		if(!bits.victim([](FrameId f) { return f % 2 == 0; }, 8, frame, examined) || frame != 3 || examined != 4)
+		{
+			PRINT_ERROR("ERROR :: The clock should pass over the frames it is told to skip.");
+		}
+		if(!bits.victim([](FrameId f) { return true; }, 0, frame, examined) || frame != 4)
+		{
+			PRINT_ERROR("ERROR :: The clock should go on past the frame it took last.");
+		}
+		//both runs have a referenced frame, so the first round only clears them
+		bits.setPinned(1, false);
+		bits.setReferenced(1, true);
+		bits.setValid(5, true);
+		bits.setReferenced(5, true);
+		FrameId head;
+		if(!bits.victimRun(4, head) || head != 0 || !bits.victimRun(4, head) || head != 4)
+		{
+			PRINT_ERROR("ERROR :: A run with a referenced frame should get a second chance.");
+		}
+		bits.assign(1);
+		bits.assign(5);
+		if(bits.victimRun(4, head))
+		{
+			PRINT_ERROR("ERROR :: A run with a pinned frame should never be taken.");
+		}
+	}
+
+	std::cout << "Frame bitmap test passed (" << (FrameBitmap::simdSweep() ? "AVX2" : "64 bit words") << ")" << "\n";
+}
+
+void testCleanVictims()
+{
+	const std::string filename = "test.clean";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		BufMgr mgr(4);
+		mgr.setCleanVictimSearch(4, 3);
+
+		//three dirty pages ahead of the clock and a clean one behind them
+		for (i = 0; i < 4; i++)
+		{
+			mgr.allocPage(&file, pid[i], page);
+			sprintf(tmpbuf, "clean Page %d %7.1f", pid[i], (float)pid[i]);
+			rid[i] = page->insertRecord(tmpbuf);
+			mgr.unPinPage(&file, pid[i], i < 3);
+		}
+
+		mgr.clearBufStats();
+		mgr.allocPage(&file, pid[4], page);
+		mgr.unPinPage(&file, pid[4], false);
+		BufStats stats = mgr.getBufStatsSnapshot();
+		if(stats.cleanVictimSkips != 3 || stats.evictions != 1 || stats.dirtyEvictions != 0)
+		{
+			PRINT_ERROR("ERROR :: The clock should have passed the dirty pages and taken the clean one.");
+		}
+
+		//the passed pages are written by the background writer, or right away once the queue is full
+		for (int wait = 0; wait < 500 && mgr.getBufStatsSnapshot().backgroundWrites < 3; wait++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		if(mgr.getBufStatsSnapshot().backgroundWrites != 3)
+		{
+			PRINT_ERROR("ERROR :: The three dirty pages should have been written back.");
+		}
+		for (i = 0; i < 3; i++)
+		{
+			Page written = file.readPage(pid[i]);
+			checkRecord(&written, rid[i], "clean", pid[i]);
+		}
+
+		//the writer wrote a copy of each page with bufMutex let go of, and recorded the checksum of that copy
+		try
+		{
+			BufMgr other(1);
+			other.readPage(&file, pid[0], page);
+			other.unPinPage(&file, pid[0], false);
+		}
+		catch(const PageChecksumException& e)
+		{
+			PRINT_ERROR("ERROR :: A page written in the background should match its checksum.");
+		}
+
+		//the dirty pages stayed, now clean, and the clean one left
+		mgr.clearBufStats();
+		for (i = 0; i < 3; i++)
+		{
+			mgr.readPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], false);
+		}
+		if(mgr.getBufStats().hits != 3)
+		{
+			PRINT_ERROR("ERROR :: The dirty pages should still be in the pool.");
+		}
+
+		//with the search off, a pool of dirty pages evicts one of them on the miss path as before
+		mgr.setCleanVictimSearch(0);
+		for (i = 0; i < 5; i++)
+		{
+			if(i == 3)
+				continue;
+			mgr.readPage(&file, pid[i], page);
+			mgr.unPinPage(&file, pid[i], true);
+		}
+		mgr.clearBufStats();
+		mgr.readPage(&file, pid[3], page);
+		mgr.unPinPage(&file, pid[3], false);
+		if(mgr.getBufStats().cleanVictimSkips != 0 || mgr.getBufStats().dirtyEvictions != 1)
+		{
+			PRINT_ERROR("ERROR :: The clock should have taken a dirty page without skipping any.");
+		}
+	}
+	removeFile(filename);
+
+	//a disposed file is done with the writer when disposeFile returns, so it can be closed right away
+	{
+		BufMgr mgr(4);
+		mgr.setCleanVictimSearch(4, 3);
+		std::uint64_t writes;
+		{
+			PageFile file = PageFile::create(filename);
+			for (i = 0; i < 4; i++)
+			{
+				mgr.allocPage(&file, pid[i], page);
+				mgr.unPinPage(&file, pid[i], i < 3);
+			}
+			mgr.allocPage(&file, pid[4], page);
+			mgr.unPinPage(&file, pid[4], false);
+			mgr.disposeFile(&file);
+			writes = mgr.getBufStatsSnapshot().backgroundWrites;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		if(mgr.getBufStatsSnapshot().backgroundWrites != writes)
+		{
+			PRINT_ERROR("ERROR :: Nothing of a disposed file should be written in the background.");
+		}
+	}
+	removeFile(filename);
+
+	std::cout << "Clean victim test passed" << "\n";
+}
+
+void testConcurrentMisses()
+{
+	const std::string filename = "test.misses";
+	removeFile(filename);
+
+	{
+		PageFile file = PageFile::create(filename);
+		{
+			BufMgr mgr(8);
+			for (i = 0; i < 8; i++)
+			{
+				mgr.allocPage(&file, pid[i], page);
+				sprintf(tmpbuf, "misses Page %d %7.1f", pid[i], (float)pid[i]);
+				rid[i] = page->insertRecord(tmpbuf);
+				mgr.unPinPage(&file, pid[i], true);
+			}
+		}
+
+		BufMgr mgr(8);
+
+#ifndef BADGERDB_BUF_SINGLE_THREADED
+		//the pages are read with bufMutex released, but each one only once however many threads miss on it
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 8; t++)
+		{
+			readers.push_back(std::thread([&mgr, &file, t]() {
+				for (PageId k = 0; k < 8; k++)
+				{
+					PageId pageNo = pid[(k + t) % 8];
+					Page* readPage;
+					mgr.readPage(&file, pageNo, readPage);
+					checkRecord(readPage, rid[(k + t) % 8], "misses", pageNo);
+					mgr.unPinPage(&file, pageNo, false);
+				}
+			}));
+		}
+		for (std::size_t t = 0; t < readers.size(); t++)
+			readers[t].join();
+		if(mgr.getBufStats().diskreads != 8 || mgr.getBufStats().hits + mgr.getBufStats().misses != 64)
+		{
+			PRINT_ERROR("ERROR :: Every page should have been read from the file exactly once.");
+		}
+#endif
+
+		//a read that fails leaves neither a frame nor a pin behind
+		BufMgr single(1);
+		file.deletePage(pid[7]);
+		for (int attempt = 0; attempt < 2; attempt++)
+		{
+			try
+			{
+				single.readPage(&file, pid[7], page);
+				PRINT_ERROR("ERROR :: The page was deleted. Exception should have been thrown before execution reaches this point.");
+			}
+			catch(const InvalidPageException& e)
+			{
+			}
+		}
+		single.readPage(&file, pid[0], page);
+		checkRecord(page, rid[0], "misses", pid[0]);
+		single.unPinPage(&file, pid[0], false);
+	}
+	removeFile(filename);
+
+	std::cout << "Concurrent miss test passed" << "\n";
+}
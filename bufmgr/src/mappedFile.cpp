@@ -0,0 +1,170 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedFile.h"
+#include "file_iterator.h"
+#include "pageImage.h"
+#include "exceptions/invalid_page_exception.h"
+#include "exceptions/mapped_file_exception.h"
+#include "exceptions/page_not_pinned_exception.h"
+
+namespace badgerdb {
+
+MappedFile::MappedFile(const std::string& pathIn, std::uint32_t idleLimitIn)
+	: path(pathIn), base(NULL), numPages(0), idleLimit(idleLimitIn), pinnedPages(0)
+{
+	fd = ::open(path.c_str(), O_RDONLY);
+	if(fd < 0) {
+		throw MappedFileException(path, "open");
+	}
+
+	struct stat st;
+	if(::fstat(fd, &st) != 0) {
+		::close(fd);
+		throw MappedFileException(path, "stat");
+	}
+	numPages = (std::uint32_t) (st.st_size / Page::SIZE);
+
+	//an empty file cannot be mapped, but it is a valid file without pages
+	if(numPages > 0) {
+		void* mapping = ::mmap(NULL, (std::size_t) numPages * Page::SIZE, PROT_READ, MAP_SHARED, fd, 0);
+		if(mapping == MAP_FAILED) {
+			::close(fd);
+			throw MappedFileException(path, "map");
+		}
+		base = static_cast<char*>(mapping);
+	}
+	pinCnts.assign(numPages, 0);
+	pageObjects.assign(numPages, NULL);
+	idlePositions.assign(numPages, idlePages.end());
+}
+
+MappedFile::~MappedFile()
+{
+	for(std::size_t i = 0; i < pageObjects.size(); i++) {
+		delete pageObjects[i];
+	}
+	if(base != NULL) {
+		::munmap(base, (std::size_t) numPages * Page::SIZE);
+	}
+	::close(fd);
+}
+
+/*
+ * All pins of a page share one Page, so it is built from the mapping only once however often it is pinned,
+ * and not again while it is kept after its last unpin.
+ */
+const Page* MappedFile::pin(const PageId pageNo)
+{
+	if(pageNo == Page::INVALID_NUMBER || pageNo > numPages) {
+		throw InvalidPageException(pageNo, path);
+	}
+
+	std::lock_guard<std::mutex> lock(pinMutex);
+	if(pinCnts[pageNo - 1] == 0) {
+		if(pageObjects[pageNo - 1] == NULL) {
+			Page* page = new Page();
+			pageFromImage(base + (std::size_t) (pageNo - 1) * Page::SIZE, *page);
+
+			//a page that was deleted before the export is a hole of zeros
+			if(page->page_number() != pageNo) {
+				delete page;
+				throw InvalidPageException(pageNo, path);
+			}
+			pageObjects[pageNo - 1] = page;
+		}
+		else {
+			idlePages.erase(idlePositions[pageNo - 1]);
+			idlePositions[pageNo - 1] = idlePages.end();
+		}
+		pinnedPages++;
+	}
+	pinCnts[pageNo - 1]++;
+	return pageObjects[pageNo - 1];
+}
+
+void MappedFile::unpin(const PageId pageNo)
+{
+	std::lock_guard<std::mutex> lock(pinMutex);
+	if(pageNo == Page::INVALID_NUMBER || pageNo > numPages || pinCnts[pageNo - 1] == 0) {
+		throw PageNotPinnedException(path, pageNo, 0);
+	}
+	if(--pinCnts[pageNo - 1] == 0) {
+		idlePositions[pageNo - 1] = idlePages.insert(idlePages.end(), pageNo);
+		pinnedPages--;
+
+		while(idlePages.size() > idleLimit) {
+			PageId oldest = idlePages.front();
+			idlePages.pop_front();
+			idlePositions[oldest - 1] = idlePages.end();
+			delete pageObjects[oldest - 1];
+			pageObjects[oldest - 1] = NULL;
+		}
+	}
+}
+
+void MappedFile::advise(MappedAccess access)
+{
+	if(base == NULL) {
+		return;
+	}
+
+	int advice = MADV_NORMAL;
+	if(access == MAPPED_SEQUENTIAL) {
+		advice = MADV_SEQUENTIAL;
+	}
+	else if(access == MAPPED_RANDOM) {
+		advice = MADV_RANDOM;
+	}
+	::madvise(base, (std::size_t) numPages * Page::SIZE, advice);
+}
+
+void MappedFile::prefetch(const PageId first, std::uint32_t count)
+{
+	if(first == Page::INVALID_NUMBER || first > numPages) {
+		return;
+	}
+	if(count > numPages - first + 1) {
+		count = numPages - first + 1;
+	}
+	::madvise(base + (std::size_t) (first - 1) * Page::SIZE, (std::size_t) count * Page::SIZE, MADV_WILLNEED);
+}
+
+/*
+ * Pages are written at the offset their number gives them, deleted pages leave a hole of zeros behind.
+ */
+std::uint32_t MappedFile::exportFile(File* file, const std::string& pathOut)
+{
+	int out = ::open(pathOut.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(out < 0) {
+		throw MappedFileException(pathOut, "open");
+	}
+
+	std::uint32_t written = 0;
+	for(FileIterator it = file->begin(); it != file->end(); ++it) {
+		Page page = *it;
+		char image[Page::SIZE];
+		pageToImage(page, image);
+		off_t offset = (off_t) (page.page_number() - 1) * Page::SIZE;
+		if(::pwrite(out, image, Page::SIZE, offset) != (ssize_t) Page::SIZE) {
+			::close(out);
+			throw MappedFileException(pathOut, "write");
+		}
+		written++;
+	}
+
+	if(::fsync(out) != 0 || ::close(out) != 0) {
+		throw MappedFileException(pathOut, "write");
+	}
+	return written;
+}
+
+}
@@ -0,0 +1,202 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+* @brief How a mapped file is going to be read, passed on to the kernel as a hint
+*/
+enum MappedAccess
+{
+  MAPPED_NORMAL,
+  MAPPED_SEQUENTIAL,
+  MAPPED_RANDOM
+};
+
+/**
+* @brief Read-only file of pages that is memory mapped instead of read through the buffer pool.
+*
+* For reference data that is never written, a MappedFile maps the whole file and reads pages from the mapping
+* instead of the file, without a read call and without taking a frame of the pool. The file holds the page
+* images, page n at offset (n - 1) * Page::SIZE, and is written once from a regular File with exportFile().
+*
+* A Page keeps its contents in its own members, so it cannot point into the mapping: a page is still copied out
+* of the kernel's page cache into a Page built for it, and is held twice while that Page lives. What is saved is
+* the read call and the frame. The Page is built on the first pin and kept after the last unpin, so pinning the
+* page again is free; up to a set number of unpinned pages are kept, the one unpinned longest ago is dropped
+* first, and the rest go when the file is unmapped.
+*
+* Pages are pinned and unpinned like pages of the buffer pool, through BufMgr::readPage(MappedFile*, ...) and
+* BufMgr::unPinPage(MappedFile*, ...). The mapping stays in place as long as any page is pinned.
+*/
+class MappedFile
+{
+ private:
+  /**
+   * Path of the file
+   */
+  std::string path;
+
+  /**
+   * Descriptor of the file
+   */
+  int fd;
+
+  /**
+   * Start of the mapping
+   */
+  char* base;
+
+  /**
+   * Number of pages in the file
+   */
+  std::uint32_t numPages;
+
+  /**
+   * Pin count of every page
+   */
+  std::vector<std::uint32_t> pinCnts;
+
+  /**
+   * Every page built from the mapping, pinned or kept after its last unpin. NULL for the others.
+   */
+  std::vector<Page*> pageObjects;
+
+  /**
+   * Pages that are built but not pinned, the one unpinned longest ago first
+   */
+  std::list<PageId> idlePages;
+
+  /**
+   * Position of every page in idlePages, idlePages.end() for pages that are not in it
+   */
+  std::vector<std::list<PageId>::iterator> idlePositions;
+
+  /**
+   * Most pages kept in idlePages
+   */
+  std::uint32_t idleLimit;
+
+  /**
+   * Number of pages with a pin count above 0
+   */
+  std::uint32_t pinnedPages;
+
+  /**
+   * Protects the pin counts, pages can be pinned from several buffer managers and threads
+   */
+  std::mutex pinMutex;
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+ public:
+  /**
+   * Constructor of MappedFile class. Maps the whole file.
+   *
+   * @param pathIn   	Path of a file written by exportFile()
+   * @param idleLimitIn   	Number of unpinned pages to keep built, so they need no copy when pinned again
+   * @throws MappedFileException If the file cannot be opened or mapped
+   */
+  explicit MappedFile(const std::string& pathIn, std::uint32_t idleLimitIn = 64);
+
+  /**
+   * Destructor of MappedFile class. Unmaps the file, no page may be pinned anymore.
+   */
+  ~MappedFile();
+
+  /**
+   * Pins a page
+   *
+   * @param pageNo   	Page number
+   * @return  The page, valid until its last pin is released
+   * @throws InvalidPageException If the file has no such page, or the page was deleted before the export
+   */
+  const Page* pin(const PageId pageNo);
+
+  /**
+   * Unpins a page
+   *
+   * @param pageNo   	Page number
+   * @throws PageNotPinnedException If the page is not pinned
+   */
+  void unpin(const PageId pageNo);
+
+  /**
+   * Tells the kernel how the file is going to be read, so it can read ahead or not
+   *
+   * @param access   	Expected access pattern
+   */
+  void advise(MappedAccess access);
+
+  /**
+   * Asks the kernel to start reading a run of pages in ahead of use
+   *
+   * @param first   	First page of the run
+   * @param count   	Number of pages in the run
+   */
+  void prefetch(const PageId first, std::uint32_t count);
+
+  /**
+   * Path of the file
+   */
+  const std::string& filename() const
+  {
+    return path;
+  }
+
+  /**
+   * Number of pages in the file
+   */
+  std::uint32_t pageCount() const
+  {
+    return numPages;
+  }
+
+  /**
+   * Number of pages that are pinned
+   */
+  std::uint32_t pinnedCount()
+  {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    return pinnedPages;
+  }
+
+  /**
+   * Number of pages that are kept built without being pinned
+   */
+  std::uint32_t idleCount()
+  {
+    std::lock_guard<std::mutex> lock(pinMutex);
+    return (std::uint32_t) idlePages.size();
+  }
+
+  /**
+   * Writes every page of a regular file out as a file that can be mapped
+   *
+   * The pages are read from the file itself, so the export only sees what has been written to it. Before it,
+   * call BufMgr::flushFile() on the file in every buffer manager that may hold dirty pages of it, and do not
+   * export a file that has a compressed store attached: its pages are in the store, the file holds stale copies.
+   *
+   * @param file   	File to export
+   * @param pathOut   	Path of the file written
+   * @return  Number of pages written
+   * @throws MappedFileException If the file cannot be written
+   */
+  static std::uint32_t exportFile(File* file, const std::string& pathOut);
+};
+
+}
@@ -0,0 +1,62 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright(c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#include <cstring>
+#include <string>
+#include "pageImage.h"
+
+namespace badgerdb {
+
+static_assert(sizeof(PageHeader) + Page::DATA_SIZE == Page::SIZE, "a page image is its header followed by its data");
+
+namespace {
+
+/*
+ * Page keeps its header and data private and only lets the file classes at them. Access is not checked
+ * for the template arguments of an explicit instantiation, which is how the pointers to the two members
+ * are taken below without changing page.h. Each Tag gets a friend function returning its member pointer.
+ */
+template<typename Tag, typename Tag::type Member>
+struct PageMember
+{
+	friend typename Tag::type memberOf(Tag)
+	{
+		return Member;
+	}
+};
+
+struct HeaderTag
+{
+	typedef PageHeader Page::*type;
+	friend type memberOf(HeaderTag);
+};
+
+struct DataTag
+{
+	typedef std::string Page::*type;
+	friend type memberOf(DataTag);
+};
+
+template struct PageMember<HeaderTag, &Page::header_>;
+template struct PageMember<DataTag, &Page::data_>;
+
+}
+
+void pageToImage(const Page& page, char* image)
+{
+	const std::string& data = page.*memberOf(DataTag());
+	std::memcpy(image, &(page.*memberOf(HeaderTag())), sizeof(PageHeader));
+	std::memcpy(image + sizeof(PageHeader), data.data(), Page::DATA_SIZE);
+}
+
+void pageFromImage(const char* image, Page& page)
+{
+	std::memcpy(&(page.*memberOf(HeaderTag())), image, sizeof(PageHeader));
+	(page.*memberOf(DataTag())).assign(image + sizeof(PageHeader), Page::DATA_SIZE);
+}
+
+}
@@ -0,0 +1,47 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+ * The buffer manager checksums, compresses and copies a page as the Page::SIZE bytes File stores it as on disk:
+ * the page header followed by the Page::DATA_SIZE bytes of page data. Page is not such a byte image itself, it
+ * keeps its data in a string, so everything that handles pages as bytes converts them with these two functions.
+ */
+
+/**
+ * Writes out the bytes of a page
+ *
+ * @param page   	Page
+ * @param image   	Buffer of Page::SIZE bytes the page is written to
+ */
+void pageToImage(const Page& page, char* image);
+
+/**
+ * Reads a page back from its bytes
+ *
+ * @param image   	Page::SIZE bytes written by pageToImage()
+ * @param page   	Page that is overwritten with them
+ */
+void pageFromImage(const char* image, Page& page);
+
+/**
+ * Offset of a page in a PageFile, which keeps its pages one after the other behind the file header
+ *
+ * @param pageNo   	Page number
+ */
+inline off_t pageFileOffset(PageId pageNo)
+{
+  return (off_t) sizeof(FileHeader) + (off_t) (pageNo - 1) * Page::SIZE;
+}
+
+}
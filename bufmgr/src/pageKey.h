@@ -0,0 +1,40 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <functional>
+#include "file.h"
+
+namespace badgerdb {
+
+/**
+* @brief Identifies a page by its file and page number, for the caches kept next to the buffer pool.
+*/
+struct PageKey
+{
+  const File* file;
+  PageId pageNo;
+
+  bool operator==(const PageKey& other) const
+  {
+    return file == other.file && pageNo == other.pageNo;
+  }
+};
+
+/**
+* @brief Hash of a PageKey for unordered containers
+*/
+struct PageKeyHash
+{
+  std::size_t operator()(const PageKey& key) const
+  {
+    return std::hash<const File*>()(key.file) ^ (std::hash<PageId>()(key.pageNo) * 0x9e3779b97f4a7c15ull);
+  }
+};
+
+}
@@ -0,0 +1,240 @@
+/**
+ * @author See Contributors.txt for code contributors and overview of BadgerDB.
+ *
+ * @section LICENSE
+ * Copyright (c) 2012 Database Group, Computer Sciences Department, University of Wisconsin-Madison.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace badgerdb {
+
+/**
+* @brief Mode in which the contents of a page are latched
+*/
+enum LatchMode
+{
+  LATCH_NONE,
+  LATCH_SHARED,
+  LATCH_EXCLUSIVE
+};
+
+/**
+* @brief Reader-writer latch on the contents of one buffer frame.
+*
+* The whole latch is one 32 bit word: the low bits count shared holders, one bit marks an exclusive holder and one
+* bit tells new readers that a writer is waiting. Taking the latch shared when nobody holds it exclusively is a
+* single fetch_add. Waiters spin with yield, which suits latches that are held for the duration of a page access
+* and not across I/O. Latches are not reentrant.
+*
+* Next to the latch word sits a version that is odd while the latch is held exclusively and moves on every time a
+* writer releases it or the frame is given to another page. Optimistic readers remember the version, read the page
+* without latching, and validate() afterwards that the version did not move.
+*/
+class PageLatch
+{
+ private:
+  /**
+   * Set while the latch is held exclusively
+   */
+  static const std::uint32_t EXCLUSIVE = 1u << 31;
+
+  /**
+   * Set while a writer waits, keeps new readers out so writers are not starved
+   */
+  static const std::uint32_t WRITER_WAITING = 1u << 30;
+
+  /**
+   * Bits counting the shared holders
+   */
+  static const std::uint32_t SHARED_MASK = WRITER_WAITING - 1;
+
+  std::atomic<std::uint32_t> word;
+
+  /**
+   * Version of the frame contents, odd while a writer holds the latch
+   */
+  std::atomic<std::uint64_t> version;
+
+  /**
+   * Mark the start of an exclusive hold. The fence keeps the writer's page updates from
+   * becoming visible before the odd version does.
+   */
+  void beginWrite()
+  {
+    version.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
+
+  /**
+   * Mark the end of an exclusive hold
+   */
+  void endWrite()
+  {
+    version.fetch_add(1, std::memory_order_release);
+  }
+
+  PageLatch(const PageLatch&) = delete;
+  PageLatch& operator=(const PageLatch&) = delete;
+
+ public:
+  PageLatch()
+    : word(0), version(0)
+  {
+  }
+
+  /**
+   * Take the latch shared, waiting while it is held or wanted exclusively
+   */
+  void lockShared()
+  {
+    //optimistically count ourselves in, and back out again if a writer got there first
+    while(word.fetch_add(1, std::memory_order_acquire) & (EXCLUSIVE | WRITER_WAITING))
+    {
+      word.fetch_sub(1, std::memory_order_relaxed);
+      while(word.load(std::memory_order_relaxed) & (EXCLUSIVE | WRITER_WAITING))
+        std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Release a shared hold
+   */
+  void unlockShared()
+  {
+    word.fetch_sub(1, std::memory_order_release);
+  }
+
+  /**
+   * Take the latch exclusive, waiting for all other holders to leave
+   */
+  void lockExclusive()
+  {
+    for(;;)
+    {
+      std::uint32_t current = word.load(std::memory_order_relaxed);
+      if((current & (EXCLUSIVE | SHARED_MASK)) == 0)
+      {
+        //clears WRITER_WAITING as well, other waiting writers set it again
+        if(word.compare_exchange_weak(current, EXCLUSIVE, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+          beginWrite();
+          return;
+        }
+        continue;
+      }
+      if((current & WRITER_WAITING) == 0)
+        word.fetch_or(WRITER_WAITING, std::memory_order_relaxed);
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Release an exclusive hold. Readers that counted themselves in while it was held are left alone.
+   */
+  void unlockExclusive()
+  {
+    endWrite();
+    word.fetch_sub(EXCLUSIVE, std::memory_order_release);
+  }
+
+  /**
+   * Turn a shared hold into an exclusive one, which only succeeds if the caller is the only holder.
+   * On failure the caller still holds the latch shared.
+   *
+   * @return  True if the latch is now held exclusively
+   */
+  bool tryUpgrade()
+  {
+    std::uint32_t current = word.load(std::memory_order_relaxed);
+    while((current & (EXCLUSIVE | SHARED_MASK)) == 1)
+    {
+      if(word.compare_exchange_weak(current, EXCLUSIVE, std::memory_order_acquire, std::memory_order_relaxed))
+      {
+        beginWrite();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * Turn an exclusive hold into a shared one without letting a writer in between
+   */
+  void downgrade()
+  {
+    endWrite();
+    word.fetch_sub(EXCLUSIVE - 1, std::memory_order_release);
+  }
+
+  /**
+   * Version to start an optimistic read with. An odd version means a writer is active and will never validate.
+   */
+  std::uint64_t currentVersion() const
+  {
+    return version.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Check that nothing changed the frame since the version was taken. Reads of the page made before
+   * this call are covered by the fence.
+   *
+   * @param seen   	Version returned by currentVersion()
+   * @return  True if the page was not written or replaced in between
+   */
+  bool validate(std::uint64_t seen) const
+  {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (seen & 1) == 0 && version.load(std::memory_order_relaxed) == seen;
+  }
+
+  /**
+   * Invalidate all optimistic reads, used when the frame is given to another page
+   */
+  void bumpVersion()
+  {
+    version.fetch_add(2, std::memory_order_release);
+  }
+
+  /**
+   * Take the latch in the given mode, does nothing for LATCH_NONE
+   */
+  void lock(LatchMode mode)
+  {
+    if(mode == LATCH_SHARED)
+      lockShared();
+    else if(mode == LATCH_EXCLUSIVE)
+      lockExclusive();
+  }
+
+  /**
+   * Check that the latch is currently held in the given mode by someone. The latch does not know its holders,
+   * so this cannot tell whether the caller is one of them. Always true for LATCH_NONE.
+   */
+  bool held(LatchMode mode) const
+  {
+    std::uint32_t current = word.load(std::memory_order_relaxed);
+    if(mode == LATCH_SHARED)
+      return (current & SHARED_MASK) != 0;
+    if(mode == LATCH_EXCLUSIVE)
+      return (current & EXCLUSIVE) != 0;
+    return true;
+  }
+
+  /**
+   * Release a hold in the given mode, does nothing for LATCH_NONE
+   */
+  void unlock(LatchMode mode)
+  {
+    if(mode == LATCH_SHARED)
+      unlockShared();
+    else if(mode == LATCH_EXCLUSIVE)
+      unlockExclusive();
+  }
+};
+
+}